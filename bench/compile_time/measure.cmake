@@ -0,0 +1,100 @@
+# Generates a translation unit per number of alternatives, compiles it and records 
+# the compile time (and the peak memory of the compiler when GNU time is available).
+# The sources are compiled with the compile rule, the standard and the flags of the calling project, see bench/CMakeLists.txt
+#
+# Usage : cmake -DCXX_COMPILER=... -DCOMPILE_RULE=... -DCOMPILE_FLAGS=... -DINCLUDE_FLAG=... -DINCLUDE_DIR=... -DOUTPUT_DIR=... 
+#               -DSIZES="16;64;256" [-DTIME_EXECUTABLE=...] -P measure.cmake
+
+# GNU time measures the elapsed time. Otherwise the clock of CMake is used, 
+# whose microseconds (%f) are only available from CMake 3.23 : whole seconds are too coarse to compare the sizes
+if(NOT TIME_EXECUTABLE AND CMAKE_VERSION VERSION_LESS 3.23)
+    message(FATAL_ERROR "Measuring the compile time needs GNU time or CMake 3.23 or later (this is CMake ${CMAKE_VERSION})")
+endif()
+
+# The command compiling source into object, from the compile rule of the project (CMAKE_CXX_COMPILE_OBJECT)
+function(compile_command source object result)
+    set(command "${COMPILE_RULE}")
+    string(REPLACE "<CMAKE_CXX_COMPILER>" "\"${CXX_COMPILER}\"" command "${command}")
+    string(REPLACE "<DEFINES>" "" command "${command}")
+    string(REPLACE "<INCLUDES>" "\"${INCLUDE_FLAG}${INCLUDE_DIR}\"" command "${command}")
+    string(REPLACE "<FLAGS>" "${COMPILE_FLAGS}" command "${command}")
+    string(REPLACE "<OBJECT>" "\"${object}\"" command "${command}")
+    string(REPLACE "<SOURCE>" "\"${source}\"" command "${command}")
+    separate_arguments(command NATIVE_COMMAND "${command}")
+
+    # Drops what only makes sense in a build system (response files, placeholders of the targets)
+    list(FILTER command EXCLUDE REGEX "<")
+    set(${result} ${command} PARENT_SCOPE)
+endfunction()
+
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+set(csv "alternatives,compile_seconds,max_rss_kb\n")
+
+foreach(size ${SIZES})
+    math(EXPR last "${size} - 1")
+
+    # Alternatives, the OneOf type, and a function using construction, copy, an exhaustive match and a visit
+    set(alternatives "")
+    set(tags "")
+    set(arms "")
+    set(handlers "")
+    foreach(i RANGE ${last})
+        string(APPEND alternatives "struct Payload${i} { int value; };\nONE_OF_CREATE_ALTERNATIVE(TAG_${i}, Payload${i})\n")
+        string(APPEND arms "    .match<TAG_${i}>([&](const Payload${i}& p) { result = p.value + ${i}; })\n")
+        if(i EQUAL 0)
+            string(APPEND tags "TAG_${i}")
+            string(APPEND handlers "        [](const Payload${i}& p) { return p.value + ${i}; }")
+        else()
+            string(APPEND tags ", TAG_${i}")
+            string(APPEND handlers ",\n        [](const Payload${i}& p) { return p.value + ${i}; }")
+        endif()
+    endforeach()
+
+    set(source "${OUTPUT_DIR}/one_of_${size}.cpp")
+    file(WRITE ${source} "#include <one_of/one_of.h>\n\n${alternatives}\ntypedef one_of::OneOf<${tags}> Big;\n\n"
+        "int use(const Big& in)\n{\n    Big copy(in);\n    copy = Big(TAG_${last}{}, Payload${last}{1});\n    int result = 0;\n"
+        "    in\n${arms}    .assertMatchIsExhaustive();\n"
+        "    return result + copy.visit(\n${handlers});\n}\n")
+
+    compile_command(${source} ${OUTPUT_DIR}/one_of_${size}${CMAKE_CXX_OUTPUT_EXTENSION} command)
+    if(TIME_EXECUTABLE)
+        execute_process(
+            COMMAND ${TIME_EXECUTABLE} -f "%e %M" ${command}
+            RESULT_VARIABLE result OUTPUT_VARIABLE compiler_output ERROR_VARIABLE time_output)
+        if(NOT result EQUAL 0)
+            message(FATAL_ERROR "Compilation of ${source} failed :\n${compiler_output}${time_output}")
+        endif()
+
+        # The last line is "<elapsed seconds> <max rss in kB>"
+        string(REGEX MATCH "([0-9]+\\.[0-9]+) ([0-9]+)[ \n]*$" time_line "${time_output}")
+        set(elapsed "${CMAKE_MATCH_1}")
+        set(max_rss "${CMAKE_MATCH_2}")
+    else()
+        string(TIMESTAMP start "%s%f")
+        execute_process(
+            COMMAND ${command}
+            RESULT_VARIABLE result OUTPUT_VARIABLE compiler_output ERROR_VARIABLE compiler_errors)
+        string(TIMESTAMP end "%s%f")
+        if(NOT result EQUAL 0)
+            message(FATAL_ERROR "Compilation of ${source} failed :\n${compiler_output}${compiler_errors}")
+        endif()
+
+        math(EXPR elapsed_ms "(${end} - ${start}) / 1000")
+        math(EXPR seconds "${elapsed_ms} / 1000")
+        math(EXPR milliseconds "${elapsed_ms} % 1000")
+        string(LENGTH "${milliseconds}" digits)
+        if(digits EQUAL 1)
+            set(milliseconds "00${milliseconds}")
+        elseif(digits EQUAL 2)
+            set(milliseconds "0${milliseconds}")
+        endif()
+        set(elapsed "${seconds}.${milliseconds}")
+        set(max_rss "n/a")
+    endif()
+
+    message(STATUS "${size} alternatives : ${elapsed} s, ${max_rss} kB")
+    string(APPEND csv "${size},${elapsed},${max_rss}\n")
+endforeach()
+
+file(WRITE ${OUTPUT_DIR}/compile_time.csv "${csv}")
+message(STATUS "Results written to ${OUTPUT_DIR}/compile_time.csv")
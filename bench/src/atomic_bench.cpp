@@ -0,0 +1,132 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <one_of/atomic_one_of.h>
+
+// --------------------------------------------------------------------------
+//                  States published between threads
+// --------------------------------------------------------------------------
+
+// Fits in a single word
+ONE_OF_CREATE_ALTERNATIVE(CONNECTING, uint32_t)
+ONE_OF_CREATE_ALTERNATIVE(CONNECTED,  uint32_t)
+ONE_OF_CREATE_ALTERNATIVE(FAILED,     uint32_t)
+typedef one_of::OneOf<CONNECTING, CONNECTED, FAILED> Connection;
+
+// Needs a sequence lock. A torn read breaks the invariant : check == ~sequence
+struct Frame { uint64_t sequence; uint64_t check; };
+ONE_OF_CREATE_ALTERNATIVE(IDLE,    uint64_t)
+ONE_OF_CREATE_ALTERNATIVE(RUNNING, Frame)
+typedef one_of::OneOf<IDLE, RUNNING> Pipeline;
+
+// --------------------------------------------------------------------------
+//                  The same API, protected by a mutex
+// --------------------------------------------------------------------------
+
+template<typename V>
+class LockedOneOf
+{
+public:
+    explicit LockedOneOf(const V& value) : _value(value) {}
+    V load() const              { std::lock_guard<std::mutex> lock(_mutex); return _value; }
+    void store(const V& value)  { std::lock_guard<std::mutex> lock(_mutex); _value = value; }
+
+private:
+    mutable std::mutex _mutex;
+    V _value;
+};
+
+// --------------------------------------------------------------------------
+//                  Workloads
+// --------------------------------------------------------------------------
+
+template<typename V> V make(uint64_t i);
+
+template<> Connection make<Connection>(uint64_t i)
+{
+    switch (i % 3)
+    {
+        case 0: return Connection(CONNECTING{}, static_cast<uint32_t>(i));
+        case 1: return Connection(CONNECTED{}, static_cast<uint32_t>(i));
+        default: return Connection(FAILED{}, static_cast<uint32_t>(i));
+    }
+}
+
+template<> Pipeline make<Pipeline>(uint64_t i)
+{
+    if (i % 2) { return Pipeline(IDLE{}, i); }
+    return Pipeline(RUNNING{}, Frame{i, ~i});
+}
+
+static bool consistent(const Connection& value)
+{
+    return value.index() < 3;
+}
+
+static bool consistent(const Pipeline& value)
+{
+    return value.visit(
+        [](const uint64_t&)         { return true; },
+        [](const Frame& frame)      { return frame.check == ~frame.sequence; });
+}
+
+/**
+ * One writer stores new values while the readers load snapshots and check them, for the given duration
+ */
+template<typename V, typename Shared>
+static bool run(const char* name, unsigned reader_count, std::chrono::milliseconds duration)
+{
+    Shared shared(make<V>(0));
+    std::atomic<bool> stop(false);
+    std::atomic<bool> torn(false);
+    std::atomic<uint64_t> reads(0);
+    uint64_t writes = 0;
+
+    std::vector<std::thread> readers;
+    for (unsigned r = 0; r < reader_count; ++r)
+    {
+        readers.emplace_back([&]()
+        {
+            uint64_t local = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                if (!consistent(shared.load())) { torn = true; }
+                ++local;
+            }
+            reads += local;
+        });
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < duration)
+    {
+        for (int i = 0; i < 64; ++i) { shared.store(make<V>(++writes)); }
+    }
+    stop = true;
+    for (std::thread& reader : readers) { reader.join(); }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << name << "," << reader_count << "," << (reads / seconds) << "," << (writes / seconds) << std::endl;
+    if (torn) { std::cerr << name << " : torn read" << std::endl; }
+    return !torn;
+}
+
+int main()
+{
+    const std::chrono::milliseconds duration(300);
+    bool ok = true;
+
+    std::cout << "benchmark,readers,reads_per_s,writes_per_s" << std::endl;
+    for (unsigned readers = 1; readers <= 4; readers *= 2)
+    {
+        ok &= run<Connection, one_of::AtomicOneOf<CONNECTING, CONNECTED, FAILED>>("atomic_word", readers, duration);
+        ok &= run<Connection, LockedOneOf<Connection>>("mutex_word", readers, duration);
+        ok &= run<Pipeline, one_of::AtomicOneOf<IDLE, RUNNING>>("atomic_seqlock", readers, duration);
+        ok &= run<Pipeline, LockedOneOf<Pipeline>>("mutex_seqlock", readers, duration);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <one_of/channel.h>
+
+// --------------------------------------------------------------------------
+//                  Requests passed from producers to consumers
+// --------------------------------------------------------------------------
+
+struct Get  { uint64_t sent; std::string path; };
+struct Post { uint64_t sent; std::string path; std::string body; };
+
+ONE_OF_CREATE_ALTERNATIVE(PING, uint64_t)
+ONE_OF_CREATE_ALTERNATIVE(GET,  Get)
+ONE_OF_CREATE_ALTERNATIVE(POST, Post)
+typedef one_of::OneOf<PING, GET, POST> Request;
+
+static uint64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t sent_at(const Request& request)
+{
+    return request.visit(
+        [](const uint64_t& sent)    { return sent; },
+        [](const Get& get)          { return get.sent; },
+        [](const Post& post)        { return post.sent; });
+}
+
+// --------------------------------------------------------------------------
+//                  The baseline : a mutex guarded deque
+// --------------------------------------------------------------------------
+
+class LockedQueue
+{
+public:
+
+    explicit LockedQueue(size_t capacity) : _capacity(capacity) {}
+
+    template<typename Tag, typename... Args>
+    void emplace(Args&&... args)
+    {
+        Request request(Tag{}, std::forward<Args>(args)...);
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_full.wait(lock, [this]() { return _queue.size() < _capacity; });
+        _queue.push_back(std::move(request));
+        _not_empty.notify_one();
+    }
+
+    template<typename Callback>
+    void consume(Callback&& cb)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_empty.wait(lock, [this]() { return !_queue.empty(); });
+        Request request = std::move(_queue.front());
+        _queue.pop_front();
+        _not_full.notify_one();
+        lock.unlock();
+        cb(request);
+    }
+
+private:
+
+    const size_t _capacity;
+    std::mutex _mutex;
+    std::condition_variable _not_empty;
+    std::condition_variable _not_full;
+    std::deque<Request> _queue;
+};
+
+// --------------------------------------------------------------------------
+//                  Workload
+// --------------------------------------------------------------------------
+
+template<typename Queue>
+static void produce(Queue& queue, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        switch (i % 3)
+        {
+            case 0: queue.template emplace<PING>(now()); break;
+            case 1: queue.template emplace<GET>(Get{now(), "/index/with/a/long/enough/path.html"}); break;
+            default: queue.template emplace<POST>(Post{now(), "/form/with/a/long/enough/path", std::string(64, 'b')}); break;
+        }
+    }
+}
+
+/**
+ * Sends message_count requests from the producers to the consumers,
+ * and reports the throughput and the latency between the emplacement and the consumption of the requests
+ */
+template<typename Queue>
+static bool run(const char* name, unsigned producer_count, unsigned consumer_count, size_t message_count)
+{
+    Queue queue(1024);
+    const size_t per_producer = message_count / producer_count;
+    const size_t per_consumer = per_producer * producer_count / consumer_count;
+    std::vector<std::vector<uint64_t>> latencies(consumer_count);
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned c = 0; c < consumer_count; ++c)
+    {
+        threads.emplace_back([&queue, &latencies, c, per_consumer]()
+        {
+            std::vector<uint64_t>& latency = latencies[c];
+            latency.reserve(per_consumer);
+            for (size_t i = 0; i < per_consumer; ++i)
+            {
+                queue.consume([&latency](Request& request) { latency.push_back(now() - sent_at(request)); });
+            }
+        });
+    }
+    for (unsigned p = 0; p < producer_count; ++p)
+    {
+        threads.emplace_back([&queue, per_producer]() { produce(queue, per_producer); });
+    }
+    for (std::thread& thread : threads) { thread.join(); }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<uint64_t> all;
+    for (const std::vector<uint64_t>& latency : latencies) { all.insert(all.end(), latency.begin(), latency.end()); }
+    if (all.size() != per_consumer * consumer_count) { std::cerr << name << " : lost messages" << std::endl; return false; }
+    std::sort(all.begin(), all.end());
+
+    std::cout << name << "," << producer_count << "," << consumer_count << "," 
+              << (all.size() / seconds) << "," << all[all.size() / 2] << "," << all[all.size() * 99 / 100] << std::endl;
+    return true;
+}
+
+int main()
+{
+    const size_t message_count = 1 << 20;
+    bool ok = true;
+
+    std::cout << "benchmark,producers,consumers,messages_per_s,p50_ns,p99_ns" << std::endl;
+    ok &= run<one_of::SpscChannel<PING, GET, POST>>("spsc_channel", 1, 1, message_count);
+    ok &= run<one_of::Channel<PING, GET, POST>>("mpmc_channel", 1, 1, message_count);
+    ok &= run<LockedQueue>("mutex_deque", 1, 1, message_count);
+    ok &= run<one_of::Channel<PING, GET, POST>>("mpmc_channel", 2, 2, message_count);
+    ok &= run<LockedQueue>("mutex_deque", 2, 2, message_count);
+    return ok ? 0 : 1;
+}
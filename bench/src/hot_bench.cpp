@@ -0,0 +1,107 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <one_of/one_of.h>
+
+// --------------------------------------------------------------------------
+//                  The same OneOf, with and without a hot alternative
+// --------------------------------------------------------------------------
+
+using one_of::details::index_sequence;
+using one_of::details::make_index_sequence;
+
+const size_t alternative_count = 8;
+const size_t hot_alternative = 5;
+
+template<size_t I> struct Plain     { typedef std::string Type; };
+template<size_t I> struct Hinted    { typedef std::string Type; };
+
+namespace one_of { template<> struct is_hot<Hinted<hot_alternative>> : std::true_type {}; }
+
+template<template<size_t> class Tag, typename Indices> struct Make {};
+template<template<size_t> class Tag, size_t... Is> struct Make<Tag, index_sequence<Is...>>
+{
+    typedef one_of::OneOf<Tag<Is>...> type;
+
+    static type create(size_t index, const std::string& payload)
+    {
+        typedef type (*Factory)(const std::string&);
+        static const Factory factories[] = { &createAlternative<Is>... };
+        return factories[index](payload);
+    }
+
+    template<size_t I> static type createAlternative(const std::string& payload) { return type(Tag<I>{}, payload); }
+
+    // A different handler per alternative, as in a real dispatch
+    template<size_t I> struct Handler { uint64_t operator()(const std::string& payload) const { return payload.size() * (I + 1); } };
+
+    static uint64_t visit(const type& value) { return value.visit(Handler<Is>()...); }
+};
+
+// --------------------------------------------------------------------------
+//                  Measures
+// --------------------------------------------------------------------------
+
+typedef std::chrono::steady_clock Clock;
+
+static volatile uint64_t sink;
+
+static double nanoseconds_per_element(Clock::duration duration, size_t elements)
+{
+    return std::chrono::duration<double, std::nano>(duration).count() / elements;
+}
+
+template<template<size_t> class Tag>
+static void run(const char* ordering, const std::vector<size_t>& indices, int rounds)
+{
+    typedef Make<Tag, make_index_sequence<alternative_count>> Maker;
+    typedef typename Maker::type Value;
+
+    std::vector<Value> values;
+    values.reserve(indices.size());
+    for (size_t index : indices) { values.push_back(Maker::create(index, "payload")); }
+
+    Clock::duration visit(0), copy(0), destroy(0);
+    for (int round = 0; round < rounds; ++round)
+    {
+        Clock::time_point start = Clock::now();
+        uint64_t result = 0;
+        for (const Value& value : values) { result += Maker::visit(value); }
+        sink = result;
+        visit += Clock::now() - start;
+
+        start = Clock::now();
+        std::vector<Value>* copies = new std::vector<Value>(values);
+        copy += Clock::now() - start;
+
+        start = Clock::now();
+        delete copies;
+        destroy += Clock::now() - start;
+    }
+
+    const size_t elements = values.size() * rounds;
+    std::cout << ordering << ",visit," << nanoseconds_per_element(visit, elements) << std::endl;
+    std::cout << ordering << ",copy," << nanoseconds_per_element(copy, elements) << std::endl;
+    std::cout << ordering << ",destroy," << nanoseconds_per_element(destroy, elements) << std::endl;
+}
+
+int main()
+{
+    const size_t element_count = 1 << 16;
+    const int rounds = 32;
+
+    // 95% of the elements hold the hot alternative, the others are spread uniformly
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> share(0.0, 1.0);
+    std::uniform_int_distribution<size_t> other(0, alternative_count - 1);
+    std::vector<size_t> indices(element_count);
+    for (size_t& index : indices) { index = share(generator) < 0.95 ? hot_alternative : other(generator); }
+
+    std::cout << "ordering,operation,ns_per_op" << std::endl;
+    run<Plain>("table", indices, rounds);
+    run<Hinted>("hot_first", indices, rounds);
+    return 0;
+}
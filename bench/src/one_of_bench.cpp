@@ -0,0 +1,338 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <one_of/one_of.h>
+
+#if __cplusplus >= 201703L
+#include <variant>
+#endif
+
+// --------------------------------------------------------------------------
+//                  Payloads
+// --------------------------------------------------------------------------
+
+using one_of::details::index_sequence;
+using one_of::details::make_index_sequence;
+
+// Every alternative of the benchmarked types holds the same payload type, under N different tags
+template<size_t I, typename T> struct Alt { typedef T Type; };
+template<size_t I, typename T> struct Repeat { typedef T type; };
+
+inline uint64_t weigh(int value)                    { return static_cast<uint64_t>(value); }
+inline uint64_t weigh(const std::string& value)     { return value.size(); }
+
+struct Weigh
+{
+    template<typename T> uint64_t operator()(const T& value) const { return weigh(value); }
+};
+
+// --------------------------------------------------------------------------
+//                  Implementations
+// --------------------------------------------------------------------------
+
+// Each implementation provides the same static functions, working on raw storage so that
+// construction and destruction are timed separately
+
+template<size_t I, size_t N, typename T>
+struct MatchChain
+{
+    template<typename Visitor>
+    static void run(Visitor&& visitor, uint64_t& result)
+    {
+        MatchChain<I + 1, N, T>::run(visitor.template match<Alt<I, T>>([&result](const T& value) { result += weigh(value); }), result);
+    }
+};
+
+template<size_t N, typename T>
+struct MatchChain<N, N, T>
+{
+    template<typename Visitor> static void run(Visitor&&, uint64_t&) {}
+};
+
+template<typename T, typename Indices> struct OneOfImpl {};
+template<typename T, size_t... Is>
+struct OneOfImpl<T, index_sequence<Is...>>
+{
+    typedef one_of::OneOf<Alt<Is, T>...> value_type;
+    static const char* name() { return "one_of"; }
+
+    template<size_t I> static void construct(void* at, const T& payload)    { new (at) value_type(Alt<I, T>{}, payload); }
+    static void copy(void* at, const value_type& value)                     { new (at) value_type(value); }
+    static void move(void* at, value_type& value)                           { new (at) value_type(std::move(value)); }
+    template<size_t I> static void emplace(value_type& value, const T& payload) { value.template emplace<Alt<I, T>>(payload); }
+    static void destroy(value_type& value)                                  { value.~value_type(); }
+
+    static uint64_t match(const value_type& value)
+    {
+        uint64_t result = 0;
+        MatchChain<1, sizeof...(Is), T>::run(value.template match<Alt<0, T>>([&result](const T& payload) { result += weigh(payload); }), result);
+        return result;
+    }
+
+    static uint64_t visit(const value_type& value)
+    {
+        return value.visit((static_cast<void>(Is), Weigh())...);
+    }
+};
+
+#if __cplusplus >= 201703L
+template<typename T, typename Indices> struct VariantImpl {};
+template<typename T, size_t... Is>
+struct VariantImpl<T, index_sequence<Is...>>
+{
+    typedef std::variant<typename Repeat<Is, T>::type...> value_type;
+    static const char* name() { return "std_variant"; }
+
+    template<size_t I> static void construct(void* at, const T& payload)    { new (at) value_type(std::in_place_index<I>, payload); }
+    static void copy(void* at, const value_type& value)                     { new (at) value_type(value); }
+    static void move(void* at, value_type& value)                           { new (at) value_type(std::move(value)); }
+    template<size_t I> static void emplace(value_type& value, const T& payload) { value.template emplace<I>(payload); }
+    static void destroy(value_type& value)                                  { value.~value_type(); }
+
+    static uint64_t match(const value_type& value)                          { return std::visit(Weigh(), value); }
+    static uint64_t visit(const value_type& value)                          { return std::visit(Weigh(), value); }
+};
+#endif
+
+template<typename T>
+struct Base
+{
+    virtual ~Base() {}
+    virtual Base* clone() const = 0;
+    virtual uint64_t accept() const = 0;
+};
+
+template<size_t I, typename T>
+struct Derived : Base<T>
+{
+    explicit Derived(const T& payload) : value(payload) {}
+    Base<T>* clone() const override     { return new Derived(*this); }
+    uint64_t accept() const override    { return weigh(value); }
+    T value;
+};
+
+template<typename T, typename Indices> struct VirtualImpl {};
+template<typename T, size_t... Is>
+struct VirtualImpl<T, index_sequence<Is...>>
+{
+    typedef std::unique_ptr<Base<T>> value_type;
+    static const char* name() { return "virtual"; }
+
+    template<size_t I> static void construct(void* at, const T& payload)    { new (at) value_type(new Derived<I, T>(payload)); }
+    static void copy(void* at, const value_type& value)                     { new (at) value_type(value->clone()); }
+    static void move(void* at, value_type& value)                           { new (at) value_type(std::move(value)); }
+    template<size_t I> static void emplace(value_type& value, const T& payload) { value.reset(new Derived<I, T>(payload)); }
+    static void destroy(value_type& value)                                  { value.~value_type(); }
+
+    static uint64_t match(const value_type& value)                          { return value->accept(); }
+    static uint64_t visit(const value_type& value)                          { return value->accept(); }
+};
+
+template<typename T>
+struct Tagged
+{
+    uint32_t tag;
+    T value;
+};
+
+// A hand-written switch over the tag, with one case per alternative. The cases past the
+// number of alternatives are dead code, removed by the compiler
+#define ONE_OF_BENCH_TAGGED_CASE(i)     case i: if (i < N) { return weigh(tagged.value); } break;
+#define ONE_OF_BENCH_TAGGED_CASES_4(i)  ONE_OF_BENCH_TAGGED_CASE(i) ONE_OF_BENCH_TAGGED_CASE(i + 1) ONE_OF_BENCH_TAGGED_CASE(i + 2) ONE_OF_BENCH_TAGGED_CASE(i + 3)
+#define ONE_OF_BENCH_TAGGED_CASES_16(i) ONE_OF_BENCH_TAGGED_CASES_4(i) ONE_OF_BENCH_TAGGED_CASES_4(i + 4) ONE_OF_BENCH_TAGGED_CASES_4(i + 8) ONE_OF_BENCH_TAGGED_CASES_4(i + 12)
+
+template<size_t N, typename T>
+uint64_t tagged_switch(const Tagged<T>& tagged)
+{
+    static_assert(N <= 32, "The switch has 32 cases");
+    switch (tagged.tag)
+    {
+        ONE_OF_BENCH_TAGGED_CASES_16(0)
+        ONE_OF_BENCH_TAGGED_CASES_16(16)
+    }
+    return 0;
+}
+
+#undef ONE_OF_BENCH_TAGGED_CASES_16
+#undef ONE_OF_BENCH_TAGGED_CASES_4
+#undef ONE_OF_BENCH_TAGGED_CASE
+
+template<typename T, typename Indices> struct TaggedImpl {};
+template<typename T, size_t... Is>
+struct TaggedImpl<T, index_sequence<Is...>>
+{
+    typedef Tagged<T> value_type;
+    static const char* name() { return "tagged_struct"; }
+
+    template<size_t I> static void construct(void* at, const T& payload)    { new (at) value_type{I, payload}; }
+    static void copy(void* at, const value_type& value)                     { new (at) value_type(value); }
+    static void move(void* at, value_type& value)                           { new (at) value_type(std::move(value)); }
+    template<size_t I> static void emplace(value_type& value, const T& payload) { value.tag = I; value.value = payload; }
+    static void destroy(value_type& value)                                  { value.~value_type(); }
+
+    static uint64_t match(const value_type& value)                          { return tagged_switch<sizeof...(Is)>(value); }
+    static uint64_t visit(const value_type& value)                          { return tagged_switch<sizeof...(Is)>(value); }
+};
+
+// --------------------------------------------------------------------------
+//                  Measures
+// --------------------------------------------------------------------------
+
+static const size_t batch_size = 1024;
+static const int rounds = 64;
+
+typedef std::chrono::steady_clock Clock;
+
+// Prevents the compiler from removing the measured work
+static volatile uint64_t sink;
+
+template<typename Impl>
+class Runner
+{
+public:
+
+    typedef typename Impl::value_type V;
+
+    template<typename T>
+    static void run(size_t alternatives, const char* payload_name, const T& payload)
+    {
+        Runner runner;
+        std::vector<std::pair<const char*, double>> results;
+
+        results.push_back(std::make_pair("construct", runner.measure(
+            [&](V*) {},
+            [&](V* objects) { for (size_t i = 0; i < batch_size; ++i) { Impl::template construct<0>(&objects[i], payload); } },
+            [&](V* objects) { runner.destroyAll(objects); })));
+
+        results.push_back(std::make_pair("copy", runner.measure(
+            [&](V*) { runner.constructAll<0>(runner._sources, payload); },
+            [&](V* objects) { for (size_t i = 0; i < batch_size; ++i) { Impl::copy(&objects[i], runner._sources[i]); } },
+            [&](V* objects) { runner.destroyAll(objects); runner.destroyAll(runner._sources); })));
+
+        results.push_back(std::make_pair("move", runner.measure(
+            [&](V*) { runner.constructAll<0>(runner._sources, payload); },
+            [&](V* objects) { for (size_t i = 0; i < batch_size; ++i) { Impl::move(&objects[i], runner._sources[i]); } },
+            [&](V* objects) { runner.destroyAll(objects); runner.destroyAll(runner._sources); })));
+
+        results.push_back(std::make_pair("emplace", runner.measure(
+            [&](V* objects) { runner.constructAll<0>(objects, payload); },
+            [&](V* objects) { for (size_t i = 0; i < batch_size; ++i) { Impl::template emplace<last>(objects[i], payload); } },
+            [&](V* objects) { runner.destroyAll(objects); })));
+
+        results.push_back(std::make_pair("match_first", runner.measureDispatch<0>(payload, [](const V& value) { return Impl::match(value); })));
+        results.push_back(std::make_pair("match_last", runner.measureDispatch<last>(payload, [](const V& value) { return Impl::match(value); })));
+        results.push_back(std::make_pair("visit_first", runner.measureDispatch<0>(payload, [](const V& value) { return Impl::visit(value); })));
+        results.push_back(std::make_pair("visit_last", runner.measureDispatch<last>(payload, [](const V& value) { return Impl::visit(value); })));
+
+        results.push_back(std::make_pair("destroy", runner.measure(
+            [&](V* objects) { runner.constructAll<0>(objects, payload); },
+            [&](V* objects) { runner.destroyAll(objects); },
+            [&](V*) {})));
+
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            std::cout << Impl::name() << "," << alternatives << "," << payload_name << "," << results[i].first << "," << results[i].second << std::endl;
+        }
+    }
+
+private:
+
+    typedef typename std::aligned_storage<sizeof(V), alignof(V)>::type Raw;
+    static constexpr size_t last = Impl::alternatives - 1;
+
+    Runner() : _objects_raw(batch_size), _sources_raw(batch_size)
+    {
+        _objects = reinterpret_cast<V*>(_objects_raw.data());
+        _sources = reinterpret_cast<V*>(_sources_raw.data());
+    }
+
+    template<size_t I, typename T>
+    void constructAll(V* objects, const T& payload)
+    {
+        for (size_t i = 0; i < batch_size; ++i) { Impl::template construct<I>(&objects[i], payload); }
+    }
+
+    void destroyAll(V* objects)
+    {
+        for (size_t i = 0; i < batch_size; ++i) { Impl::destroy(objects[i]); }
+    }
+
+    /**
+     * @return the time taken by the timed step, per object, in nanoseconds. The setup and teardown steps are not timed
+     */
+    template<typename Setup, typename Timed, typename Teardown>
+    double measure(Setup setup, Timed timed, Teardown teardown)
+    {
+        Clock::duration total(0);
+        for (int round = 0; round < rounds; ++round)
+        {
+            setup(_objects);
+            const Clock::time_point start = Clock::now();
+            timed(_objects);
+            total += Clock::now() - start;
+            teardown(_objects);
+        }
+        return std::chrono::duration<double, std::nano>(total).count() / (rounds * batch_size);
+    }
+
+    // Takes the dispatch as a callable rather than a function pointer, so that it is inlined in the timed loop
+    template<size_t I, typename T, typename Dispatch>
+    double measureDispatch(const T& payload, Dispatch dispatch)
+    {
+        return measure(
+            [&](V* objects) { constructAll<I>(objects, payload); },
+            [&](V* objects)
+            {
+                uint64_t result = 0;
+                for (size_t i = 0; i < batch_size; ++i) { result += dispatch(objects[i]); }
+                sink = result;
+            },
+            [&](V* objects) { destroyAll(objects); });
+    }
+
+    std::vector<Raw> _objects_raw;
+    std::vector<Raw> _sources_raw;
+    V* _objects;
+    V* _sources;
+};
+
+// Gives the number of alternatives to the runner
+template<template<typename, typename> class Impl, typename T, size_t N>
+struct Sized : Impl<T, make_index_sequence<N>>
+{
+    static constexpr size_t alternatives = N;
+};
+
+template<typename T, size_t N>
+void run_all(const char* payload_name, const T& payload)
+{
+    Runner<Sized<OneOfImpl, T, N>>::run(N, payload_name, payload);
+#if __cplusplus >= 201703L
+    Runner<Sized<VariantImpl, T, N>>::run(N, payload_name, payload);
+#endif
+    Runner<Sized<VirtualImpl, T, N>>::run(N, payload_name, payload);
+    Runner<Sized<TaggedImpl, T, N>>::run(N, payload_name, payload);
+}
+
+template<typename T>
+void run_sizes(const char* payload_name, const T& payload)
+{
+    run_all<T, 2>(payload_name, payload);
+    run_all<T, 8>(payload_name, payload);
+    run_all<T, 32>(payload_name, payload);
+}
+
+int main()
+{
+    std::cout << "implementation,alternatives,payload,operation,ns_per_op" << std::endl;
+    run_sizes("int", 42);
+    run_sizes("string_8", std::string(8, 'a'));
+    run_sizes("string_1024", std::string(1024, 'a'));
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <one_of/shared_one_of.h>
+
+// --------------------------------------------------------------------------
+//                  A response broadcast to many subscribers
+// --------------------------------------------------------------------------
+
+struct Response     { typedef std::string Type; };
+struct Error        { typedef int Type; };
+
+typedef one_of::OneOf<Response, Error> Message;
+typedef one_of::SharedOneOf<Response, Error> SharedMessage;
+
+typedef std::chrono::steady_clock Clock;
+
+static volatile uint64_t sink;
+
+static uint64_t weigh(const Message& message)
+{
+    return message.visit([](const std::string& body) -> uint64_t { return body.size(); },
+                         [](int code) -> uint64_t { return static_cast<uint64_t>(code); });
+}
+
+static uint64_t weigh(const SharedMessage& message)
+{
+    return weigh(message.get());
+}
+
+/**
+ * @return the time taken to give a copy of the message to each subscriber, and to read and drop the copies, per subscriber
+ */
+template<typename M>
+static double fan_out(const M& message, size_t subscribers, int rounds)
+{
+    std::vector<M> inboxes;
+    inboxes.reserve(subscribers);
+
+    uint64_t result = 0;
+    const Clock::time_point start = Clock::now();
+    for (int round = 0; round < rounds; ++round)
+    {
+        for (size_t i = 0; i < subscribers; ++i) { inboxes.push_back(message); }
+        for (const M& inbox : inboxes) { result += weigh(inbox); }
+        inboxes.clear();
+    }
+    sink = result;
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (static_cast<double>(rounds) * subscribers);
+}
+
+// The subscribers are threads, each reading its own copy
+template<typename M>
+static double fan_out_threads(const M& message, size_t threads, size_t copies_per_thread)
+{
+    const Clock::time_point start = Clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&message, copies_per_thread]()
+        {
+            uint64_t result = 0;
+            for (size_t i = 0; i < copies_per_thread; ++i)
+            {
+                const M copy(message);
+                result += weigh(copy);
+            }
+            sink = result;
+        });
+    }
+    for (std::thread& worker : workers) { worker.join(); }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (static_cast<double>(threads) * copies_per_thread);
+}
+
+int main()
+{
+    const size_t subscribers = 512;
+    const int rounds = 200;
+
+    std::cout << "Fan out to " << subscribers << " subscribers, in ns per subscriber" << std::endl;
+    for (size_t body_size : {16, 1024, 16 * 1024})
+    {
+        const Message message(Response{}, std::string(body_size, 'x'));
+        const SharedMessage shared(message);
+
+        std::cout << "  body of " << body_size << " bytes : OneOf copies " << fan_out(message, subscribers, rounds)
+                  << ", SharedOneOf " << fan_out(shared, subscribers, rounds) << std::endl;
+    }
+
+    const size_t threads = 4;
+    const size_t copies = 100000;
+    const Message message(Response{}, std::string(16 * 1024, 'x'));
+    const SharedMessage shared(message);
+
+    std::cout << "Fan out of a 16 KB body to " << threads << " threads, in ns per copy : OneOf copies " << fan_out_threads(message, threads, copies)
+              << ", SharedOneOf " << fan_out_threads(shared, threads, copies) << std::endl;
+
+    // Mutating clones the shared payload, leaving the other owners untouched
+    SharedMessage owner(shared);
+    owner.mutate().match<Response>([](std::string& body) { body.assign("changed"); });
+    return weigh(shared) == 16 * 1024 && weigh(owner) == 7 ? 0 : 1;
+}
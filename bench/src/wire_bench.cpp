@@ -0,0 +1,96 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <one_of/wire.h>
+
+// --------------------------------------------------------------------------
+//                  Messages exchanged on the wire
+// --------------------------------------------------------------------------
+
+struct Position { double x; double y; double z; };
+
+ONE_OF_CREATE_ALTERNATIVE(HEARTBEAT, uint64_t)
+ONE_OF_CREATE_ALTERNATIVE(POSITION,  Position)
+ONE_OF_CREATE_ALTERNATIVE(TEXT,      std::string)
+typedef one_of::OneOf<HEARTBEAT, POSITION, TEXT> Message;
+typedef one_of::OneOfView<HEARTBEAT, POSITION, TEXT> MessageView;
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char* name, size_t bytes, double seconds)
+{
+    std::cout << name << "," << bytes << "," << seconds << "," << (bytes / seconds / 1e6) << std::endl;
+}
+
+int main()
+{
+    const size_t message_count = 1000000;
+    const int rounds = 10;
+
+    std::vector<Message> messages;
+    messages.reserve(message_count);
+    for (size_t i = 0; i < message_count; ++i)
+    {
+        switch (i % 3)
+        {
+            case 0: messages.push_back(Message(HEARTBEAT{}, static_cast<uint64_t>(i))); break;
+            case 1: messages.push_back(Message(POSITION{}, Position{1.0 * i, 2.0 * i, 3.0 * i})); break;
+            default: messages.push_back(Message(TEXT{}, std::string(32 + i % 64, 'a'))); break;
+        }
+    }
+
+    std::cout << "benchmark,bytes,seconds,mb_per_s" << std::endl;
+
+    // Encoding
+    std::vector<char> buffer;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round)
+    {
+        buffer.clear();
+        for (const Message& message : messages) { one_of::encode(message, buffer); }
+    }
+    report("encode", buffer.size() * rounds, seconds_since(start));
+
+    // Matching in place, without decoding the payloads
+    const char* end = buffer.data() + buffer.size();
+    uint64_t checksum = 0;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round)
+    {
+        for (const char* data = buffer.data(); data < end; )
+        {
+            MessageView view(data);
+            checksum += view.visit(
+                [](const uint64_t& heartbeat)       { return heartbeat; },
+                [](const Position& position)        { return static_cast<uint64_t>(position.x); },
+                [](one_of::StringView text)         { return static_cast<uint64_t>(text.size); });
+            data += view.encodedSize();
+        }
+    }
+    report("view_visit", buffer.size() * rounds, seconds_since(start));
+
+    // Decoding into OneOfs, checking the round trip
+    size_t decoded = 0;
+    start = std::chrono::steady_clock::now();
+    for (const char* data = buffer.data(); data < end; ++decoded)
+    {
+        MessageView view(data);
+        if (!view.isValid(end - data)) { std::cerr << "Invalid message " << decoded << std::endl; return 1; }
+
+        const Message message = view.decode();
+        const bool same = message.index() == messages[decoded].index() && message.visit(
+            [&](const uint64_t& heartbeat)      { return messages[decoded].visit([&](const uint64_t& h) { return h == heartbeat; }, [](const Position&) { return false; }, [](const std::string&) { return false; }); },
+            [&](const Position& position)       { return messages[decoded].visit([](const uint64_t&) { return false; }, [&](const Position& p) { return p.x == position.x && p.y == position.y && p.z == position.z; }, [](const std::string&) { return false; }); },
+            [&](const std::string& text)        { return messages[decoded].visit([](const uint64_t&) { return false; }, [](const Position&) { return false; }, [&](const std::string& t) { return t == text; }); });
+        if (!same) { std::cerr << "Round trip failed for message " << decoded << std::endl; return 1; }
+        data += view.encodedSize();
+    }
+    report("decode", buffer.size(), seconds_since(start));
+
+    return (decoded == message_count && checksum != 0) ? 0 : 1;
+}
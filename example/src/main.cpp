@@ -2,53 +2,28 @@
 #include <map>
 #include <string>
 
+#include <one_of/layout.h>
 #include <one_of/one_of.h>
 
-// --------------------------------------------------------------------------
-//                  Define the Request "OneOf" type
-// --------------------------------------------------------------------------
-
-// Data structure for authentication information
-struct AuthenticationData
-{
-    std::string username;
-    std::string password;
-};
-
-// A request that requires authentication, contains the session token and some data
-template<typename T>
-class AuthentifiedRequest
-{       
-public:
-    T data;
-    std::string session_token;
-};
-
-struct Empty{};
-
-// Define the Request type with various request kinds
-ONE_OF_CREATE_ALTERNATIVE(SIGN_IN,      AuthenticationData)                 // Signin request, contains username and password
-ONE_OF_CREATE_ALTERNATIVE(LOGIN,        AuthenticationData)                 // Login request, contains username and password
-ONE_OF_CREATE_ALTERNATIVE(LOGOUT,       AuthentifiedRequest<Empty>)         // Logout request, no additional data
-ONE_OF_CREATE_ALTERNATIVE(POST_MESSAGE, AuthentifiedRequest<std::string>)   // Post message request, contains the message to post
-typedef one_of::OneOf<SIGN_IN, LOGIN, LOGOUT, POST_MESSAGE> Request;
+#include "types.h"
 
 // --------------------------------------------------------------------------
-//                  Define the Response "OneOf" type
+//      Define a constant table of OneOfs, built at compile time
 // --------------------------------------------------------------------------
 
-// Data structure for error information
-struct ErrorData
-{
-    int code;
-    std::string message;
+// The rate limit of each request kind, in the order of the Request tags. 
+// Its alternatives are literal types, so the table is initialized at compile time and needs no startup code
+static constexpr RateLimit rate_limits[] = {
+    RateLimit(RATE_LIMITED{}, Window{5, 60}),       // SIGN_IN
+    RateLimit(RATE_LIMITED{}, Window{10, 60}),      // LOGIN
+    RateLimit(UNLIMITED{}),                         // LOGOUT
+    RateLimit(RATE_LIMITED{}, Window{100, 60}),     // POST_MESSAGE
 };
 
-// Define the Response type with various response kinds
-ONE_OF_CREATE_ALTERNATIVE(AUTH_OK,  std::string)    // Response to a successful login or sign-in, contains a session token
-ONE_OF_CREATE_ALTERNATIVE(OK,       Empty)          // Generic OK response
-ONE_OF_CREATE_ALTERNATIVE(ERROR,    ErrorData)      // Error response, contains an error code and message
-typedef one_of::OneOf<AUTH_OK, OK, ERROR> Response;
+static_assert(rate_limits[2].index() == 0 && rate_limits[3].index() == 1, "The table of rate limits must be built at compile time");
+
+// Fails the build if an alternative added to RateLimit makes it larger than 12 bytes
+ONE_OF_ASSERT_SIZE_AT_MOST(RateLimit, 12);
 
 // --------------------------------------------------------------------------
 //              Create a simple server to handle requests
@@ -61,53 +36,45 @@ public:
     // Handle incoming requests and produce appropriate responses
     Response handleRequest(const Request& request)
     {
-        Response response(ERROR{}, ErrorData{1, "Internal error"});
-
-        request.match<SIGN_IN>([&](const AuthenticationData& req)
+        return request.visit(
+        [&](const AuthenticationData& req) -> Response // SIGN_IN
         {
             if(user_database.find(req.username) != user_database.end()) {
-                response.emplace<ERROR>(ErrorData{2, "User already exists"});
-                return;
+                return Response(ERROR{}, ErrorData{2, "User already exists"});
             }
             user_database[req.username] = req.password;
             std::string session_token = "token_" + req.username; // Simplified token generation
             active_sessions[session_token] = req.username;
-            response.emplace<AUTH_OK>(session_token);
-        })
-        .match<LOGIN>([&](const AuthenticationData& req)
+            return Response(AUTH_OK{}, session_token);
+        },
+        [&](const AuthenticationData& req) -> Response // LOGIN
         {
             auto it = user_database.find(req.username);
             if(it == user_database.end() || it->second != req.password) {
-                response.emplace<ERROR>(ErrorData{3, "Invalid credentials"});
-                return;
+                return Response(ERROR{}, ErrorData{3, "Invalid credentials"});
             }
             std::string session_token = "token_" + req.username; // Simplified token generation
             active_sessions[session_token] = req.username;
-            response.emplace<AUTH_OK>(session_token);
-        })
-        .match<LOGOUT>([&](const AuthentifiedRequest<Empty>& req)
+            return Response(AUTH_OK{}, session_token);
+        },
+        [&](const AuthentifiedRequest<Empty>& req) -> Response // LOGOUT
         {
             auto it = active_sessions.find(req.session_token);
             if(it == active_sessions.end()) {
-                response.emplace<ERROR>(ErrorData{4, "Invalid session"});
-                return;
+                return Response(ERROR{}, ErrorData{4, "Invalid session"});
             }
             active_sessions.erase(it);
-            response.emplace<OK>();
-        })
-        .match<POST_MESSAGE>([&](const AuthentifiedRequest<std::string>& req)
+            return Response(OK{});
+        },
+        [&](const AuthentifiedRequest<std::string>& req) -> Response // POST_MESSAGE
         {
             auto it = active_sessions.find(req.session_token);
             if(it == active_sessions.end()) {
-                response.emplace<ERROR>(ErrorData{4, "Invalid session"});
-                return;
+                return Response(ERROR{}, ErrorData{4, "Invalid session"});
             }
             message_database[it->second] = req.data;
-            response = OK();
-        })
-        .assertMatchIsExhaustive();
-
-        return response;
+            return OK();
+        });
     }
 
 private:
@@ -197,4 +164,22 @@ int main()
     {
         std::cout << "LOGOUT response type" << std::endl;
     });
+
+    // --------------------------------------------------------------------------
+    // Read the constant table of rate limits
+    // --------------------------------------------------------------------------
+
+    for (const RateLimit& rate_limit : rate_limits)
+    {
+        rate_limit
+        .match<RATE_LIMITED>([](const Window& window)
+        {
+            std::cout << "Rate limited to " << window.requests << " requests every " << window.seconds << " seconds" << std::endl;
+        })
+        .match<UNLIMITED>([](const Empty&)
+        {
+            std::cout << "Not rate limited" << std::endl;
+        })
+        .assertMatchIsExhaustive();
+    }
 }
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+
+#include <one_of/one_of.h>
+
+// The OneOf types of the example, shared with the layout report of the tools
+
+// --------------------------------------------------------------------------
+//                  Define the Request "OneOf" type
+// --------------------------------------------------------------------------
+
+// Data structure for authentication information
+struct AuthenticationData
+{
+    std::string username;
+    std::string password;
+};
+
+// A request that requires authentication, contains the session token and some data
+template<typename T>
+class AuthentifiedRequest
+{       
+public:
+    T data;
+    std::string session_token;
+};
+
+struct Empty{};
+
+// Define the Request type with various request kinds
+ONE_OF_CREATE_ALTERNATIVE(SIGN_IN,      AuthenticationData)                 // Signin request, contains username and password
+ONE_OF_CREATE_ALTERNATIVE(LOGIN,        AuthenticationData)                 // Login request, contains username and password
+ONE_OF_CREATE_ALTERNATIVE(LOGOUT,       AuthentifiedRequest<Empty>)         // Logout request, no additional data
+ONE_OF_CREATE_ALTERNATIVE(POST_MESSAGE, AuthentifiedRequest<std::string>)   // Post message request, contains the message to post
+typedef one_of::OneOf<SIGN_IN, LOGIN, LOGOUT, POST_MESSAGE> Request;
+
+// --------------------------------------------------------------------------
+//                  Define the Response "OneOf" type
+// --------------------------------------------------------------------------
+
+// Data structure for error information
+struct ErrorData
+{
+    int code;
+    std::string message;
+};
+
+// Define the Response type with various response kinds
+ONE_OF_CREATE_ALTERNATIVE(AUTH_OK,  std::string)    // Response to a successful login or sign-in, contains a session token
+ONE_OF_CREATE_ALTERNATIVE(OK,       Empty)          // Generic OK response
+ONE_OF_CREATE_ALTERNATIVE(ERROR,    ErrorData)      // Error response, contains an error code and message
+typedef one_of::OneOf<AUTH_OK, OK, ERROR> Response;
+
+// --------------------------------------------------------------------------
+//                  Define the RateLimit "OneOf" type
+// --------------------------------------------------------------------------
+
+// Data structure for a rate limit
+struct Window
+{
+    int requests;
+    int seconds;
+};
+
+ONE_OF_CREATE_ALTERNATIVE(UNLIMITED,    Empty)
+ONE_OF_CREATE_ALTERNATIVE(RATE_LIMITED, Window)
+typedef one_of::OneOf<UNLIMITED, RATE_LIMITED> RateLimit;
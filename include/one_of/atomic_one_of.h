@@ -0,0 +1,259 @@
+#pragma once
+
+#include "one_of.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <thread>
+#include <type_traits>
+
+namespace one_of
+{
+namespace details
+{
+    template<typename V>
+    V from_bytes(const void* bytes)
+    {
+        typename std::aligned_storage<sizeof(V), alignof(V)>::type raw;
+        memcpy(&raw, bytes, sizeof(V));
+        return *reinterpret_cast<const V*>(&raw);
+    }
+
+    /**
+     * A trivially copyable value stored in a single atomic word : all operations are lock-free. 
+     * Loads, stores and exchanges are single atomic instructions, compareExchange retries while other threads change the word
+     */
+    template<typename V, bool SingleWord = (sizeof(V) <= sizeof(uint64_t))>
+    class AtomicStorage
+    {
+    public:
+
+        explicit AtomicStorage(const V& value) : _word(toWord(value)) {}
+
+        V load() const                          { return fromWord(_word.load(std::memory_order_acquire)); }
+        void store(const V& value)              { _word.store(toWord(value), std::memory_order_release); }
+        V exchange(const V& value)              { return fromWord(_word.exchange(toWord(value), std::memory_order_acq_rel)); }
+
+        bool compareExchange(uint32_t expected_index, const V& desired)
+        {
+            const uint64_t desired_word = toWord(desired);
+            uint64_t current = _word.load(std::memory_order_acquire);
+            while (fromWord(current).index() == expected_index)
+            {
+                if (_word.compare_exchange_weak(current, desired_word, std::memory_order_acq_rel, std::memory_order_acquire)) { return true; }
+            }
+            return false;
+        }
+
+    private:
+
+        static uint64_t toWord(const V& value)
+        {
+            uint64_t word = 0;
+            memcpy(&word, &value, sizeof(V));
+            return word;
+        }
+
+        static V fromWord(uint64_t word)
+        {
+            return from_bytes<V>(&word);
+        }
+
+        std::atomic<uint64_t> _word;
+    };
+
+    /**
+     * A trivially copyable value protected by a sequence lock : readers never block writers,
+     * and retry if a write happened while they were copying the value
+     */
+    template<typename V>
+    class AtomicStorage<V, false>
+    {
+    public:
+
+        explicit AtomicStorage(const V& value) : _sequence(0)
+        {
+            write(value);
+        }
+
+        V load() const
+        {
+            uint64_t words[word_count];
+            for (;;)
+            {
+                const uint32_t before = _sequence.load(std::memory_order_acquire);
+                if (before & 1) { std::this_thread::yield(); continue; }
+
+                for (size_t i = 0; i < word_count; ++i) { words[i] = _words[i].load(std::memory_order_relaxed); }
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                if (_sequence.load(std::memory_order_relaxed) == before) { return from_bytes<V>(words); }
+            }
+        }
+
+        void store(const V& value)
+        {
+            const uint32_t sequence = lock();
+            write(value);
+            unlock(sequence);
+        }
+
+        V exchange(const V& value)
+        {
+            const uint32_t sequence = lock();
+            const V previous = read();
+            write(value);
+            unlock(sequence);
+            return previous;
+        }
+
+        bool compareExchange(uint32_t expected_index, const V& desired)
+        {
+            const uint32_t sequence = lock();
+            const bool matches = read().index() == expected_index;
+            if (matches) { write(desired); }
+            unlock(sequence);
+            return matches;
+        }
+
+    private:
+
+        static constexpr size_t word_count = (sizeof(V) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        // Makes the sequence odd, waiting for other writers
+        uint32_t lock()
+        {
+            uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                if (!(sequence & 1) && _sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed))
+                {
+                    std::atomic_thread_fence(std::memory_order_release);
+                    return sequence + 1;
+                }
+                if (sequence & 1)
+                {
+                    std::this_thread::yield();
+                    sequence = _sequence.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void unlock(uint32_t sequence)
+        {
+            _sequence.store(sequence + 1, std::memory_order_release);
+        }
+
+        // Only called by the writer holding the lock
+        V read() const
+        {
+            uint64_t words[word_count];
+            for (size_t i = 0; i < word_count; ++i) { words[i] = _words[i].load(std::memory_order_relaxed); }
+            return from_bytes<V>(words);
+        }
+
+        void write(const V& value)
+        {
+            uint64_t words[word_count] = {};
+            memcpy(words, &value, sizeof(V));
+            for (size_t i = 0; i < word_count; ++i) { _words[i].store(words[i], std::memory_order_relaxed); }
+        }
+
+        std::atomic<uint32_t> _sequence;
+        std::atomic<uint64_t> _words[word_count];
+    };
+}
+
+    /**
+     * A OneOf that can be read and written concurrently by several threads, without tearing.
+     * OneOfs of up to 8 bytes are stored in a single atomic word, and all operations are lock-free.
+     * Larger ones are protected by a sequence lock : writers are serialized,
+     * and readers retry (without blocking writers) when a write happened while they were reading.
+     * @tparam Tags : the tags of the OneOf, which must all be trivially copyable
+     */
+    template<typename... Tags>
+    class AtomicOneOf
+    {
+    public:
+
+        typedef OneOf<Tags...> value_type;
+
+        static_assert(std::is_trivially_copyable<value_type>::value, "AtomicOneOf requires trivially copyable alternatives");
+
+        /**
+         * True if all operations are lock-free (the OneOf fits in a single atomic word, whose operations are lock-free). 
+         * They are not wait-free : compare_exchange retries while other threads change the value
+         */
+        static constexpr bool is_always_lock_free = sizeof(value_type) <= sizeof(uint64_t) && ATOMIC_LLONG_LOCK_FREE == 2;
+
+        explicit AtomicOneOf(const value_type& value) : _storage(value) {}
+
+        AtomicOneOf(const AtomicOneOf&) = delete;
+        AtomicOneOf& operator=(const AtomicOneOf&) = delete;
+
+        /**
+         * @return a snapshot of the current value, that can be matched while other threads keep on writing
+         */
+        value_type load() const
+        {
+            return _storage.load();
+        }
+
+        void store(const value_type& value)
+        {
+            _storage.store(value);
+        }
+
+        /**
+         * Replaces the current value
+         * @return the previous value
+         */
+        value_type exchange(const value_type& value)
+        {
+            return _storage.exchange(value);
+        }
+
+        /**
+         * Replaces the current value if its tag has the given index
+         * @param expected_index the index of the expected tag
+         * @param desired the new value
+         * @return true if the value has been replaced
+         */
+        bool compare_exchange(uint32_t expected_index, const value_type& desired)
+        {
+            return _storage.compareExchange(expected_index, desired);
+        }
+
+        /**
+         * Replaces the current value if its tag is the given one
+         * @tparam Tag the expected tag
+         * @param desired the new value
+         * @return true if the value has been replaced
+         */
+        template<typename Tag>
+        bool compare_exchange(const value_type& desired)
+        {
+            return _storage.compareExchange(details::index_of<Tag, typename value_type::Variant>::value, desired);
+        }
+
+        /**
+         * Visits a snapshot of the current value with one handler per tag, in the order of the tags
+         * @param handlers the functions to call, the one matching the current tag will be called
+         * @return the value returned by the called handler
+         */
+        template<typename... Handlers>
+        typename details::visit_result<details::type_list<const typename Tags::Type&...>, details::type_list<Handlers...>>::type
+        visit(Handlers&&... handlers) const
+        {
+            const value_type snapshot = load();
+            return snapshot.visit(std::forward<Handlers>(handlers)...);
+        }
+
+    private:
+
+        details::AtomicStorage<value_type> _storage;
+    };
+
+    template<typename... Tags> constexpr bool AtomicOneOf<Tags...>::is_always_lock_free;
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "one_of.h"
+#include "details/work_stealing_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <vector>
+
+namespace one_of
+{
+namespace details
+{
+    inline void prefetch(const void* address)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address);
+#else
+        (void)address;
+#endif
+    }
+
+    /**
+     * The elements of a range, grouped by tag : 
+     * the elements of the I-th tag are elements[offsets[I]] to elements[offsets[I + 1] - 1]
+     */
+    template<typename Pointer>
+    struct Buckets
+    {
+        std::vector<Pointer> elements;
+        std::vector<size_t> offsets;
+    };
+
+    // Counting sort of the addresses of the elements on their index
+    template<typename Pointer, typename Iterator>
+    Buckets<Pointer> bucketize(Iterator first, Iterator last, uint32_t alternatives)
+    {
+        Buckets<Pointer> buckets;
+        buckets.offsets.assign(alternatives + 1, 0);
+        for (Iterator it = first; it != last; ++it) { ++buckets.offsets[it->index() + 1]; }
+        for (uint32_t i = 0; i < alternatives; ++i) { buckets.offsets[i + 1] += buckets.offsets[i]; }
+
+        std::vector<size_t> next(buckets.offsets.begin(), buckets.offsets.end() - 1);
+        buckets.elements.resize(buckets.offsets.back());
+        for (Iterator it = first; it != last; ++it) { buckets.elements[next[it->index()]++] = &*it; }
+        return buckets;
+    }
+
+    // Every element of the group has the given tag, so the match always succeeds and its branch is always predicted
+    template<typename Tag, size_t I, typename Pointer, typename HandlerTuple>
+    void visit_group(Pointer const* elements, size_t count, HandlerTuple& handlers)
+    {
+        static const size_t prefetch_distance = 8;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (i + prefetch_distance < count) { prefetch(elements[i + prefetch_distance]); }
+            elements[i]->template match<Tag>(get_ref<I>(handlers));
+        }
+    }
+
+    template<typename Pointer, typename HandlerTuple, typename... Tags, size_t... Is>
+    void visit_buckets(const Buckets<Pointer>& buckets, HandlerTuple& handlers, type_list<Tags...>, index_sequence<Is...>)
+    {
+        int expand[] = { (visit_group<Tags, Is>(buckets.elements.data() + buckets.offsets[Is], buckets.offsets[Is + 1] - buckets.offsets[Is], handlers), 0)... };
+        (void)expand;
+    }
+
+    /**
+     * The tasks submitted to the shared pool by a parallel visit. Once the calling thread has run out of chunks, 
+     * the tasks that have not started yet return at once : the call only waits for the ones that are running
+     */
+    struct Helpers
+    {
+        std::mutex mutex;
+        std::condition_variable idle;
+        size_t running;
+        bool closed;
+
+        Helpers() : running(0), closed(false) {}
+    };
+
+    template<typename Pointer, typename HandlerTuple, typename... Tags, size_t... Is>
+    void parallel_visit_buckets(const Buckets<Pointer>& buckets, HandlerTuple& handlers, size_t thread_count, type_list<Tags...>, index_sequence<Is...>)
+    {
+        typedef void (*GroupVisitor)(Pointer const*, size_t, HandlerTuple&);
+        static constexpr GroupVisitor visitors[] = { &visit_group<Tags, Is, Pointer, HandlerTuple>... };
+
+        WorkStealingPool& pool = shared_pool();
+        thread_count = std::min(thread_count, pool.size() + 1);
+
+        // Each group is split in chunks, so that large groups are shared between threads
+        struct Chunk { uint32_t index; size_t begin; size_t end; };
+        const size_t chunk_size = std::max<size_t>(1024, buckets.elements.size() / (thread_count * 4) + 1);
+        std::vector<Chunk> chunks;
+        for (uint32_t i = 0; i < sizeof...(Tags); ++i)
+        {
+            for (size_t begin = buckets.offsets[i]; begin < buckets.offsets[i + 1]; begin += chunk_size)
+            {
+                Chunk chunk = { i, begin, std::min(begin + chunk_size, buckets.offsets[i + 1]) };
+                chunks.push_back(chunk);
+            }
+        }
+
+        std::atomic<size_t> next_chunk(0);
+        std::vector<std::exception_ptr> errors(thread_count);
+        auto work = [&](size_t thread)
+        {
+            try
+            {
+                for (size_t c = next_chunk++; c < chunks.size(); c = next_chunk++)
+                {
+                    visitors[chunks[c].index](buckets.elements.data() + chunks[c].begin, chunks[c].end - chunks[c].begin, handlers);
+                }
+            }
+            catch (...)
+            {
+                errors[thread] = std::current_exception();
+            }
+        };
+
+        // The helpers outlive this call if they are still queued, but only touch its locals while it waits for them
+        const std::shared_ptr<Helpers> helpers = std::make_shared<Helpers>();
+        try
+        {
+            for (size_t thread = 1; thread < thread_count && thread < chunks.size(); ++thread)
+            {
+                pool.submit([helpers, &work, thread]()
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(helpers->mutex);
+                        if (helpers->closed) { return; }
+                        ++helpers->running;
+                    }
+                    work(thread);
+                    {
+                        std::lock_guard<std::mutex> lock(helpers->mutex);
+                        --helpers->running;
+                    }
+                    helpers->idle.notify_all();
+                });
+            }
+        }
+        catch (...)
+        {
+            // The chunks of the helpers that could not be submitted are visited by the others
+        }
+
+        work(0);
+        {
+            std::unique_lock<std::mutex> lock(helpers->mutex);
+            helpers->closed = true;
+            helpers->idle.wait(lock, [&]() { return helpers->running == 0; });
+        }
+
+        for (const std::exception_ptr& error : errors)
+        {
+            if (error) { std::rethrow_exception(error); }
+        }
+    }
+}
+
+    /**
+     * Visits a range of OneOfs, grouped by tag : the elements are first sorted by tag,
+     * then each handler is called on all the elements of its tag, one group after the other.
+     * The elements of a group are visited in the order of the range.
+     * @param first the beginning of the range of OneOfs
+     * @param last the end of the range of OneOfs
+     * @param handlers the functions to call, one per tag, in the order of the tags
+     */
+    template<typename Iterator, typename... Handlers>
+    void visit_batch(Iterator first, Iterator last, Handlers&&... handlers)
+    {
+        typedef typename std::remove_reference<decltype(*first)>::type Element;
+        typedef typename details::tags_of<Element>::type Tags;
+        static_assert(sizeof...(Handlers) == details::size_of<typename Element::Variant>::value, "visit_batch expects exactly one handler per alternative");
+
+        const details::Buckets<Element*> buckets = details::bucketize<Element*>(first, last, sizeof...(Handlers));
+        details::ref_tuple<Handlers...> handler_refs(handlers...);
+        details::visit_buckets(buckets, handler_refs, Tags(), details::index_sequence_for<Handlers...>());
+    }
+
+    /**
+     * Visits a range of OneOfs grouped by tag, like visit_batch, sharing the groups between several threads.
+     * The calling thread is helped by the threads of a pool shared by all the calls, which is started on first use 
+     * with one thread per hardware thread : no thread is created or joined by the following calls.
+     * The handlers are called concurrently and must therefore be thread-safe. 
+     * If handlers throw, one of the exceptions is rethrown once all threads are done.
+     * @param first the beginning of the range of OneOfs
+     * @param last the end of the range of OneOfs
+     * @param thread_count the maximum number of threads visiting the range (including the calling thread), 
+     *        which is bounded by the number of hardware threads
+     * @param handlers the functions to call, one per tag, in the order of the tags
+     */
+    template<typename Iterator, typename... Handlers>
+    void parallel_visit_batch(Iterator first, Iterator last, size_t thread_count, Handlers&&... handlers)
+    {
+        typedef typename std::remove_reference<decltype(*first)>::type Element;
+        typedef typename details::tags_of<Element>::type Tags;
+        static_assert(sizeof...(Handlers) == details::size_of<typename Element::Variant>::value, "parallel_visit_batch expects exactly one handler per alternative");
+
+        const details::Buckets<Element*> buckets = details::bucketize<Element*>(first, last, sizeof...(Handlers));
+        details::ref_tuple<Handlers...> handler_refs(handlers...);
+        details::parallel_visit_buckets(buckets, handler_refs, std::max<size_t>(thread_count, 1), Tags(), details::index_sequence_for<Handlers...>());
+    }
+}
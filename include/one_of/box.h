@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace one_of
+{
+    /**
+     * Default allocator of boxed alternatives : each thread keeps a free list of blocks per size and alignment,
+     * so that boxing and unboxing do not go through the global allocator in steady state.
+     * 
+     * Allocators of boxed alternatives are stateless and must provide :
+     *  - static void* allocate(size_t size, size_t alignment)
+     *  - static void deallocate(void* block, size_t size, size_t alignment)
+     * A user arena is plugged by forwarding these two functions to it.
+     */
+    class FreeListPool
+    {
+    public:
+
+        static void* allocate(size_t size, size_t alignment)
+        {
+            FreeList& list = freeList(size, alignment);
+            if (list.head == nullptr) { return ::operator new(blockSize(size)); }   // The whole size class, so that the block can serve any size of the class
+
+            Block* block = list.head;
+            list.head = block->next;
+            --list.count;
+            return block;
+        }
+
+        static void deallocate(void* block, size_t size, size_t alignment)
+        {
+            FreeList& list = freeList(size, alignment);
+            if (list.count == max_cached_blocks) { ::operator delete(block); return; }
+
+            Block* freed = static_cast<Block*>(block);
+            freed->next = list.head;
+            list.head = freed;
+            ++list.count;
+        }
+
+    private:
+
+        static constexpr size_t max_cached_blocks = 64;
+
+        struct Block { Block* next; };
+
+        struct FreeList
+        {
+            Block* head = nullptr;
+            size_t count = 0;
+
+            // Blocks released after the destruction of the list (by static objects) go straight to the global allocator
+            ~FreeList()
+            {
+                while (head != nullptr)
+                {
+                    Block* next = head->next;
+                    ::operator delete(head);
+                    head = next;
+                }
+                count = max_cached_blocks;
+            }
+        };
+
+        static constexpr size_t granularity = alignof(std::max_align_t);
+        static constexpr size_t size_classes = 64;
+
+        // Blocks are cached per multiple of the granularity, so every block is rounded up to it
+        static size_t sizeClass(size_t size) { return ((size < sizeof(Block) ? sizeof(Block) : size) + granularity - 1) / granularity; }
+        static size_t blockSize(size_t size) { return sizeClass(size) * granularity; }
+
+        // ::operator new returns blocks suitably aligned for any fundamental type
+        static FreeList& freeList(size_t size, size_t alignment)
+        {
+            (void)alignment;
+            const size_t size_class = sizeClass(size);
+            if (size_class < size_classes)
+            {
+                static thread_local FreeList lists[size_classes];
+                return lists[size_class];
+            }
+
+            // Large blocks are not cached
+            static thread_local FreeList uncached;
+            uncached.count = max_cached_blocks;
+            return uncached;
+        }
+    };
+
+    /**
+     * Owns a value allocated out of line by the given allocator. 
+     * Moving a box transfers the ownership of the value and leaves the moved-from box empty : 
+     * it can then only be destroyed, and reaching its value fails an assertion in debug builds.
+     * @tparam T the type of the boxed value
+     * @tparam Allocator the allocator of the value (see FreeListPool)
+     */
+    template<typename T, typename Allocator = FreeListPool>
+    class Box
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned types can not be boxed");
+
+    public:
+
+        template<typename... Args>
+        explicit Box(Args&&... args) : _value(static_cast<T*>(Allocator::allocate(sizeof(T), alignof(T))))
+        {
+            try
+            {
+                new (static_cast<void*>(_value)) T(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                Allocator::deallocate(_value, sizeof(T), alignof(T));
+                throw;
+            }
+        }
+
+        Box(Box&& other) noexcept : _value(other._value)
+        {
+            other._value = nullptr;
+        }
+
+        Box(const Box&) = delete;
+        Box& operator=(const Box&) = delete;
+        Box& operator=(Box&&) = delete;
+
+        ~Box()
+        {
+            if (_value == nullptr) { return; }
+            _value->~T();
+            Allocator::deallocate(_value, sizeof(T), alignof(T));
+        }
+
+        T& get()                { assert(_value != nullptr && "The boxed value has been moved"); return *_value; }
+        const T& get() const    { assert(_value != nullptr && "The boxed value has been moved"); return *_value; }
+
+        /**
+         * @return whether the value has been moved to another box
+         */
+        bool empty() const      { return _value == nullptr; }
+
+    private:
+
+        T* _value;
+    };
+}
@@ -0,0 +1,330 @@
+#pragma once
+
+#include "one_of.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace one_of
+{
+    /**
+     * Size of the cache lines : the slots of the channels and their indices are padded to it, to avoid false sharing
+     */
+    constexpr size_t cache_line_size = 64;
+
+namespace details
+{
+    // -----------------------------------------------
+    // Cache line aligned slots
+    // -----------------------------------------------
+
+    template<typename T>
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type value;
+        bool skipped;   // published without a value, because its constructor threw (multi-producer ring only)
+
+        T& get() { return *reinterpret_cast<T*>(&value); }
+    };
+
+    template<typename T>
+    struct PaddedSlot : Slot<T>
+    {
+        char padding[cache_line_size - sizeof(Slot<T>) % cache_line_size];
+    };
+
+    // Aligned, so that the index starts its own cache line instead of sharing one with the neighbouring fields. 
+    // Heap allocated channels need C++17 (or -faligned-new) to honour the alignment
+    struct alignas(cache_line_size) PaddedIndex
+    {
+        std::atomic<size_t> value;
+        char padding[cache_line_size - sizeof(std::atomic<size_t>)];
+    };
+
+    // A power of two number of slots, whose first one starts on a cache line
+    template<typename T>
+    class SlotArray
+    {
+    public:
+
+        explicit SlotArray(size_t capacity) :
+            _mask(roundUp(capacity) - 1),
+            _buffer(new char[(_mask + 1) * sizeof(PaddedSlot<T>) + cache_line_size])
+        {
+            void* first = _buffer.get();
+            size_t space = (_mask + 1) * sizeof(PaddedSlot<T>) + cache_line_size;
+            _slots = static_cast<PaddedSlot<T>*>(std::align(cache_line_size, (_mask + 1) * sizeof(PaddedSlot<T>), first, space));
+            for (size_t i = 0; i <= _mask; ++i)
+            {
+                new (static_cast<void*>(&_slots[i])) PaddedSlot<T>();
+                _slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        size_t capacity() const             { return _mask + 1; }
+        PaddedSlot<T>& at(size_t position)  { return _slots[position & _mask]; }
+
+    private:
+
+        static size_t roundUp(size_t capacity)
+        {
+            size_t result = 1;
+            while (result < capacity) { result <<= 1; }
+            return result;
+        }
+
+        const size_t _mask;
+        std::unique_ptr<char[]> _buffer;
+        PaddedSlot<T>* _slots;
+    };
+
+    // Destroys the consumed value and releases its slot, even if the consumer throws
+    template<typename T, typename Release>
+    struct ConsumeGuard
+    {
+        T& value;
+        Release release;
+        ~ConsumeGuard() { value.~T(); release(); }
+    };
+
+    // -----------------------------------------------
+    // Rings
+    // -----------------------------------------------
+
+    /**
+     * Bounded ring for a single producer and a single consumer thread
+     */
+    template<typename T>
+    class SpscRing
+    {
+    public:
+
+        explicit SpscRing(size_t capacity) : _slots(capacity)
+        {
+            _head.value.store(0, std::memory_order_relaxed);
+            _tail.value.store(0, std::memory_order_relaxed);
+        }
+
+        ~SpscRing()
+        {
+            while (tryConsume([](T&) {})) {}
+        }
+
+        size_t capacity() const { return _slots.capacity(); }
+
+        template<typename Construct>
+        bool tryProduce(Construct&& construct)
+        {
+            const size_t tail = _tail.value.load(std::memory_order_relaxed);
+            if (tail - _head.value.load(std::memory_order_acquire) == _slots.capacity()) { return false; }
+
+            construct(static_cast<void*>(&_slots.at(tail).value));
+            _tail.value.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        template<typename Consume>
+        bool tryConsume(Consume&& consume)
+        {
+            const size_t head = _head.value.load(std::memory_order_relaxed);
+            if (head == _tail.value.load(std::memory_order_acquire)) { return false; }
+
+            std::atomic<size_t>& released = _head.value;
+            auto release = [&released, head]() { released.store(head + 1, std::memory_order_release); };
+            ConsumeGuard<T, decltype(release)> guard{_slots.at(head).get(), release};
+            consume(guard.value);
+            return true;
+        }
+
+    private:
+
+        SlotArray<T> _slots;
+        PaddedIndex _head;
+        PaddedIndex _tail;
+    };
+
+    /**
+     * Bounded ring for any number of producer and consumer threads.
+     * Each slot holds a sequence number telling whether it is ready to be written or read for a given position
+     */
+    template<typename T>
+    class MpmcRing
+    {
+    public:
+
+        explicit MpmcRing(size_t capacity) : _slots(capacity)
+        {
+            _head.value.store(0, std::memory_order_relaxed);
+            _tail.value.store(0, std::memory_order_relaxed);
+        }
+
+        ~MpmcRing()
+        {
+            while (tryConsume([](T&) {})) {}
+        }
+
+        size_t capacity() const { return _slots.capacity(); }
+
+        template<typename Construct>
+        bool tryProduce(Construct&& construct)
+        {
+            size_t position = _tail.value.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Slot<T>& slot = _slots.at(position);
+                const ptrdiff_t difference = static_cast<ptrdiff_t>(slot.sequence.load(std::memory_order_acquire) - position);
+                if (difference == 0)
+                {
+                    if (_tail.value.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        // The position is claimed : it must be published, even without a value, 
+                        // or the consumers would wait for it forever
+                        try
+                        {
+                            construct(static_cast<void*>(&slot.value));
+                        }
+                        catch (...)
+                        {
+                            slot.skipped = true;
+                            slot.sequence.store(position + 1, std::memory_order_release);
+                            throw;
+                        }
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (difference < 0) { return false; }
+                else { position = _tail.value.load(std::memory_order_relaxed); }
+            }
+        }
+
+        template<typename Consume>
+        bool tryConsume(Consume&& consume)
+        {
+            size_t position = _head.value.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Slot<T>& slot = _slots.at(position);
+                const ptrdiff_t difference = static_cast<ptrdiff_t>(slot.sequence.load(std::memory_order_acquire) - (position + 1));
+                if (difference == 0)
+                {
+                    if (_head.value.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        const size_t next = position + _slots.capacity();
+                        if (slot.skipped)
+                        {
+                            slot.skipped = false;
+                            slot.sequence.store(next, std::memory_order_release);
+                            position = _head.value.load(std::memory_order_relaxed);
+                            continue;
+                        }
+
+                        std::atomic<size_t>& sequence = slot.sequence;
+                        auto release = [&sequence, next]() { sequence.store(next, std::memory_order_release); };
+                        ConsumeGuard<T, decltype(release)> guard{slot.get(), release};
+                        consume(guard.value);
+                        return true;
+                    }
+                }
+                else if (difference < 0) { return false; }
+                else { position = _head.value.load(std::memory_order_relaxed); }
+            }
+        }
+
+    private:
+
+        SlotArray<T> _slots;
+        PaddedIndex _head;
+        PaddedIndex _tail;
+    };
+}
+
+    /**
+     * A bounded, lock-free queue of OneOfs. Producers construct the OneOfs directly in the slots of the queue,
+     * and consumers access them in place, so payloads are never copied.
+     *
+     * If the constructor of an alternative throws, the exception is propagated and nothing is sent : 
+     * a multi-producer ring publishes the slot it claimed as skipped, and consumers pass over it.
+     * @tparam Ring : details::SpscRing (one producer and one consumer thread) or details::MpmcRing (any number of threads)
+     * @tparam Tags : the tags of the OneOfs sent through the channel
+     */
+    template<template<typename> class Ring, typename... Tags>
+    class BasicChannel
+    {
+    public:
+
+        typedef OneOf<Tags...> value_type;
+
+        /**
+         * @param capacity the minimum number of OneOfs the channel can hold, rounded up to a power of two
+         */
+        explicit BasicChannel(size_t capacity) : _ring(capacity) {}
+
+        BasicChannel(const BasicChannel&) = delete;
+        BasicChannel& operator=(const BasicChannel&) = delete;
+
+        size_t capacity() const { return _ring.capacity(); }
+
+        /**
+         * Constructs a OneOf holding the given tag in the next free slot
+         * @tparam Tag the tag of the OneOf
+         * @param args the arguments of the constructor of the alternative
+         * @return false if the channel is full, in which case nothing is constructed
+         */
+        template<typename Tag, typename... Args>
+        bool try_emplace(Args&&... args)
+        {
+            return _ring.tryProduce([&](void* address) { new (address) value_type(Tag{}, std::forward<Args>(args)...); });
+        }
+
+        /**
+         * Same as try_emplace, but waits for a free slot
+         */
+        template<typename Tag, typename... Args>
+        void emplace(Args&&... args)
+        {
+            while (!try_emplace<Tag>(std::forward<Args>(args)...)) { std::this_thread::yield(); }
+        }
+
+        /**
+         * Calls the given function with the oldest OneOf of the channel, in place.
+         * The OneOf is destroyed and its slot released when the function returns
+         * @param cb the function to call with a value_type&, which can match it or move it out
+         * @return false if the channel is empty, in which case the function is not called
+         */
+        template<typename Callback>
+        bool try_consume(Callback&& cb)
+        {
+            return _ring.tryConsume(std::forward<Callback>(cb));
+        }
+
+        /**
+         * Same as try_consume, but waits for a OneOf
+         */
+        template<typename Callback>
+        void consume(Callback&& cb)
+        {
+            while (!try_consume(cb)) { std::this_thread::yield(); }
+        }
+
+    private:
+
+        Ring<value_type> _ring;
+    };
+
+    /**
+     * Channel for any number of producer and consumer threads
+     */
+    template<typename... Tags> using Channel = BasicChannel<details::MpmcRing, Tags...>;
+
+    /**
+     * Faster channel for exactly one producer and one consumer thread
+     */
+    template<typename... Tags> using SpscChannel = BasicChannel<details::SpscRing, Tags...>;
+}
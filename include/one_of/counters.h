@@ -0,0 +1,248 @@
+#pragma once
+
+#include "one_of.h"
+#include "details/type_name.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace one_of
+{
+    /**
+     * An event observed by Counters, forwarded to the sink
+     */
+    struct InstrumentationEvent
+    {
+        enum Kind { Constructed, Emplaced, Copied, Matched };
+
+        Kind kind;
+        uint32_t index;             // the index of the alternative
+        uint64_t nanoseconds;       // the time spent in the handler, for Matched events
+    };
+
+    typedef std::function<void(const InstrumentationEvent&)> InstrumentationSink;
+
+    struct AlternativeStats
+    {
+        std::string tag;
+        uint64_t constructed;
+        uint64_t emplaced;
+        uint64_t copied;
+        uint64_t matched;
+        uint64_t match_nanoseconds;
+    };
+
+    /**
+     * The histogram of the alternatives of a OneOf type
+     */
+    struct InstrumentationReport
+    {
+        std::string type;
+        std::vector<AlternativeStats> alternatives;
+    };
+
+    inline std::ostream& operator<<(std::ostream& out, const InstrumentationReport& report)
+    {
+        out << report.type << "\n";
+        for (const AlternativeStats& stats : report.alternatives)
+        {
+            out << "  " << stats.tag
+                << " constructed=" << stats.constructed
+                << " emplaced=" << stats.emplaced
+                << " copied=" << stats.copied
+                << " matched=" << stats.matched
+                << " match_ns=" << stats.match_nanoseconds << "\n";
+        }
+        return out;
+    }
+
+namespace details
+{
+    // The report functions of the instrumented types, registered when they record their first event
+    struct ReportRegistry
+    {
+        std::mutex mutex;
+        std::vector<InstrumentationReport (*)()> reports;
+
+        static ReportRegistry& instance()
+        {
+            static ReportRegistry registry;
+            return registry;
+        }
+    };
+}
+
+    /**
+     * Instrumentation counting, per alternative, the constructions, emplacements, copies and matches of a OneOf type,
+     * and the time spent in the handlers. Every event is also forwarded to an optional sink.
+     *
+     * Enable it for a OneOf type right after its definition :
+     *     typedef one_of::OneOf<A, B> MyOneOf;
+     *     namespace one_of { template<> struct instrumentation<MyOneOf> : Counters<MyOneOf> {}; }
+     * @tparam O the OneOf type
+     */
+    template<typename O> class Counters;
+
+    template<typename... Tags>
+    class Counters<OneOf<Tags...>>
+    {
+    public:
+
+        static constexpr bool enabled = true;
+
+        typedef std::chrono::steady_clock::time_point Timer;
+
+        static void constructed(uint32_t index)     { record(InstrumentationEvent::Constructed, index, 0); }
+        static void emplaced(uint32_t index)        { record(InstrumentationEvent::Emplaced, index, 0); }
+        static void copied(uint32_t index)          { record(InstrumentationEvent::Copied, index, 0); }
+
+        static Timer beginMatch(uint32_t)
+        {
+            return std::chrono::steady_clock::now();
+        }
+
+        static void endMatch(uint32_t index, const Timer& start)
+        {
+            const uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            record(InstrumentationEvent::Matched, index, nanoseconds);
+        }
+
+        /**
+         * Sets the function called for each event. It must be set before the OneOfs are used concurrently
+         * @param sink the function to call, or an empty function to only count
+         */
+        static void setSink(InstrumentationSink sink)
+        {
+            state().sink = std::move(sink);
+        }
+
+        /**
+         * @return the counters of each alternative since the start of the program, or the last reset
+         */
+        static InstrumentationReport report()
+        {
+            static const std::string tags[] = { details::type_name<Tags>()... };
+
+            const State& counters = state();
+            InstrumentationReport result;
+            result.type = details::type_name<OneOf<Tags...>>();
+            for (size_t i = 0; i < sizeof...(Tags); ++i)
+            {
+                const Alternative& alternative = counters.alternatives[i];
+                result.alternatives.push_back(AlternativeStats{
+                    tags[i],
+                    alternative.events[InstrumentationEvent::Constructed].load(std::memory_order_relaxed),
+                    alternative.events[InstrumentationEvent::Emplaced].load(std::memory_order_relaxed),
+                    alternative.events[InstrumentationEvent::Copied].load(std::memory_order_relaxed),
+                    alternative.events[InstrumentationEvent::Matched].load(std::memory_order_relaxed),
+                    alternative.match_nanoseconds.load(std::memory_order_relaxed)});
+            }
+            return result;
+        }
+
+        static void reset()
+        {
+            for (Alternative& alternative : state().alternatives)
+            {
+                for (std::atomic<uint64_t>& events : alternative.events) { events.store(0, std::memory_order_relaxed); }
+                alternative.match_nanoseconds.store(0, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+
+        struct Alternative
+        {
+            std::atomic<uint64_t> events[4];
+            std::atomic<uint64_t> match_nanoseconds;
+        };
+
+        struct State
+        {
+            Alternative alternatives[sizeof...(Tags)];
+            InstrumentationSink sink;
+
+            State()
+            {
+                for (Alternative& alternative : alternatives)
+                {
+                    for (std::atomic<uint64_t>& events : alternative.events) { events.store(0, std::memory_order_relaxed); }
+                    alternative.match_nanoseconds.store(0, std::memory_order_relaxed);
+                }
+
+                details::ReportRegistry& registry = details::ReportRegistry::instance();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                registry.reports.push_back(&Counters::report);
+            }
+        };
+
+        static State& state()
+        {
+            static State counters;
+            return counters;
+        }
+
+        static void record(InstrumentationEvent::Kind kind, uint32_t index, uint64_t nanoseconds)
+        {
+            State& counters = state();
+            counters.alternatives[index].events[kind].fetch_add(1, std::memory_order_relaxed);
+            if (kind == InstrumentationEvent::Matched) { counters.alternatives[index].match_nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed); }
+            if (counters.sink) { counters.sink(InstrumentationEvent{kind, index, nanoseconds}); }
+        }
+    };
+
+    template<typename... Tags> constexpr bool Counters<OneOf<Tags...>>::enabled;
+
+    /**
+     * @return the reports of all the OneOf types instrumented with Counters that recorded at least one event
+     */
+    inline std::vector<InstrumentationReport> instrumentation_reports()
+    {
+        details::ReportRegistry& registry = details::ReportRegistry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        std::vector<InstrumentationReport> reports;
+        for (InstrumentationReport (*report)() : registry.reports) { reports.push_back(report()); }
+        return reports;
+    }
+
+    /**
+     * Writes a header declaring the hot alternatives of the reported OneOf type : the ones that took 
+     * at least the given share of its matches (or of its constructions, if it was never matched).
+     * Including the generated header before the OneOf type is used orders its dispatch by the measured frequencies
+     * @param out where to write the header
+     * @param report the report of an instrumented OneOf type, see Counters::report
+     * @param min_share the minimum share of the traffic, in [0, 1], of a hot alternative
+     */
+    inline void write_hot_alternatives(std::ostream& out, const InstrumentationReport& report, double min_share = 0.25)
+    {
+        uint64_t matched = 0;
+        uint64_t constructed = 0;
+        for (const AlternativeStats& stats : report.alternatives)
+        {
+            matched += stats.matched;
+            constructed += stats.constructed;
+        }
+
+        out << "// Generated by one_of::write_hot_alternatives for " << report.type << "\n";
+        out << "#pragma once\n\n#include <one_of/hot.h>\n\nnamespace one_of\n{\n";
+        for (const AlternativeStats& stats : report.alternatives)
+        {
+            const double share = matched > 0 ? static_cast<double>(stats.matched) / matched : 
+                                 constructed > 0 ? static_cast<double>(stats.constructed) / constructed : 0.0;
+            if (share > 0.0 && share >= min_share)
+            {
+                out << "    template<> struct is_hot<" << stats.tag << "> : std::true_type {};   // " 
+                    << std::fixed << std::setprecision(1) << (share * 100) << "% of the traffic\n";
+            }
+        }
+        out << "}\n";
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "meta.h"
+#include "tagged_union.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+namespace one_of
+{
+    /**
+     * Declares that two values of T are equal if and only if their bytes are equal, so that OneOfs made of such
+     * alternatives are compared with memcmp and hashed from their bytes instead of through a jump table.
+     * True for integers, enums and pointers : specialize it for structs without padding that are compared member by member
+     * @tparam T the type of the alternative
+     */
+    template<typename T>
+    struct is_trivially_comparable : std::integral_constant<bool, 
+        std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value> {};
+
+namespace details 
+{
+    template<typename... Tags> struct all_trivially_comparable : all_of<is_trivially_comparable<stored_type<Tags>>::value...> {};
+
+    template<typename... Tags> struct payload_sizes
+    {
+        static constexpr size_t values[sizeof...(Tags)] = { sizeof(stored_type<Tags>)... };
+    };
+
+    template<typename... Tags> constexpr size_t payload_sizes<Tags...>::values[];
+
+    // -----------------------------------------------
+    // Comparison of payloads of the same alternative
+    // -----------------------------------------------
+
+    template<typename Tag, typename V> constexpr bool equal_alternative(const V& a, const V& b)    { return get<Tag>(a) == get<Tag>(b); }
+    template<typename Tag, typename V> constexpr bool less_alternative(const V& a, const V& b)     { return get<Tag>(a) < get<Tag>(b); }
+
+    // Class members rather than local statics, so that the comparisons can be constant expressions
+    template<typename... Tags> struct comparison_tables
+    {
+        typedef bool (*Entry)(const TaggedUnion<Tags...>&, const TaggedUnion<Tags...>&);
+        static constexpr Entry equal[] = { &equal_alternative<Tags, TaggedUnion<Tags...>>... };
+        static constexpr Entry less[] = { &less_alternative<Tags, TaggedUnion<Tags...>>... };
+    };
+
+    template<typename... Tags> constexpr typename comparison_tables<Tags...>::Entry comparison_tables<Tags...>::equal[];
+    template<typename... Tags> constexpr typename comparison_tables<Tags...>::Entry comparison_tables<Tags...>::less[];
+
+    // memcmp is not allowed in constant expressions, where the table is used instead
+    template<typename... Tags>
+    constexpr bool equal_payloads(const TaggedUnion<Tags...>& a, const TaggedUnion<Tags...>& b, uint32_t index, std::true_type)
+    {
+        return ONE_OF_IS_CONSTANT_EVALUATED() ? 
+            comparison_tables<Tags...>::equal[index](a, b) : 
+            memcmp(&a, &b, payload_sizes<Tags...>::values[index]) == 0;
+    }
+
+    template<typename... Tags>
+    constexpr bool equal_payloads(const TaggedUnion<Tags...>& a, const TaggedUnion<Tags...>& b, uint32_t index, std::false_type)
+    {
+        return comparison_tables<Tags...>::equal[index](a, b);
+    }
+
+    // The bytes of little endian integers are not ordered like the integers : ordering always goes through the table
+    template<typename... Tags>
+    constexpr bool less_payloads(const TaggedUnion<Tags...>& a, const TaggedUnion<Tags...>& b, uint32_t index)
+    {
+        return comparison_tables<Tags...>::less[index](a, b);
+    }
+}}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "meta.h"
+#include "tagged_union.h"
+#include "../instrumentation.h"
+
+#include <new>
+#include <stdint.h>
+#include <type_traits>
+#include <utility>
+
+namespace one_of
+{
+    /**
+     * The tags of the result of OneOf::try_narrow :
+     * Narrowed holds the narrowed OneOf, NotNarrowed means that the active tag is not one of its tags
+     * @tparam Target the OneOf type to narrow to
+     */
+    template<typename Target> struct Narrowed { typedef Target Type; };
+    struct NotNarrowed { typedef NotNarrowed Type; };
+
+    template<typename Target> using NarrowResult = OneOf<Narrowed<Target>, NotNarrowed>;
+
+namespace details
+{
+    // Position of T among the tags, or the number of tags if it is not one of them
+    template<typename T, typename... Tags>
+    struct position_of
+    {
+        static constexpr bool matches[sizeof...(Tags)] = { std::is_same<T, Tags>::value... };
+        static constexpr uint32_t value = find_first(matches, sizeof...(Tags), true);
+    };
+
+    template<typename T, typename... Tags> constexpr bool position_of<T, Tags...>::matches[];
+
+    // The payload of a tag is stored the same way in every OneOf, at the address of its union. 
+    // Copies go through the value, since a boxed payload is not copyable but its value is
+    template<typename Tag> void copy_payload(void* to, const void* from)   { ::new (to) stored_type<Tag>(get_at<Tag>(from)); }
+    template<typename Tag> void move_payload(void* to, void* from)         { ::new (to) stored_type<Tag>(std::move(*static_cast<stored_type<Tag>*>(from))); }
+
+    /**
+     * How to convert the payload of an alternative to another OneOf type holding the same tag
+     * @tparam Payload const void to copy the payload, void to move it
+     */
+    template<typename Payload>
+    struct Conversion
+    {
+        void (*construct)(void*, Payload*);
+        uint32_t to;    // the index of the tag in the destination, or its number of tags if it has no such tag
+    };
+
+    // The conversion of the payload of a given OneOf, which the destination OneOf is constructed from
+    template<typename Payload>
+    struct Converting
+    {
+        const Conversion<Payload>& conversion;
+        Payload* payload;
+    };
+
+    // The conversions of each alternative of From to To, indexed by the index in From,
+    // so that a conversion is a single lookup followed by the copy or the move of the payload
+    template<typename From, typename To> struct copy_conversions {};
+    template<typename From, typename To> struct move_conversions {};
+
+    template<typename... From, typename... To>
+    struct copy_conversions<OneOf<From...>, OneOf<To...>>
+    {
+        static constexpr Conversion<const void> entries[] = { { &copy_payload<From>, position_of<From, To...>::value }... };
+    };
+
+    template<typename... From, typename... To>
+    struct move_conversions<OneOf<From...>, OneOf<To...>>
+    {
+        static constexpr Conversion<void> entries[] = { { &move_payload<From>, position_of<From, To...>::value }... };
+    };
+
+    template<typename... From, typename... To> constexpr Conversion<const void> copy_conversions<OneOf<From...>, OneOf<To...>>::entries[];
+    template<typename... From, typename... To> constexpr Conversion<void> move_conversions<OneOf<From...>, OneOf<To...>>::entries[];
+
+    // Whether all the tags of From are tags of To
+    template<typename From, typename To> struct is_widening : std::false_type {};
+    template<typename... From, typename... To>
+    struct is_widening<OneOf<From...>, OneOf<To...>> : all_of<(position_of<From, To...>::value < sizeof...(To))...> {};
+
+    // Whether all the tags of From, except the given one, are tags of To
+    template<typename Tag, typename From, typename To> struct keeps_other_tags : std::false_type {};
+    template<typename Tag, typename... From, typename... To>
+    struct keeps_other_tags<Tag, OneOf<From...>, OneOf<To...>> 
+        : all_of<(std::is_same<Tag, From>::value || position_of<From, To...>::value < sizeof...(To))...> {};
+}
+}
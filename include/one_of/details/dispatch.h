@@ -0,0 +1,64 @@
+#pragma once
+
+#include "meta.h"
+#include "../hot.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+namespace one_of {
+namespace details {
+
+    // -----------------------------------------------
+    // Indices of the hot alternatives
+    // -----------------------------------------------
+
+    template<typename... Tags>
+    struct hot_flags
+    {
+        static constexpr uint32_t size = sizeof...(Tags);
+        static constexpr bool values[sizeof...(Tags)] = { is_hot<Tags>::value... };
+        static constexpr uint32_t count = details::count(values, sizeof...(Tags), true);
+    };
+
+    template<typename... Tags> constexpr bool hot_flags<Tags...>::values[];
+
+    template<typename Flags, typename Ns> struct hot_indices_impl {};
+    template<typename Flags, size_t... Ns> struct hot_indices_impl<Flags, index_sequence<Ns...>>
+    {
+        typedef index_sequence<find_nth(Flags::values, 0, Flags::size, Ns, true)...> type;
+    };
+
+    template<typename... Tags> 
+    using hot_indices = typename hot_indices_impl<hot_flags<Tags...>, make_index_sequence<hot_flags<Tags...>::count>>::type;
+
+    // -----------------------------------------------
+    // Dispatch through a table, hot entries first
+    // -----------------------------------------------
+
+    /**
+     * Calls the entry of the table at the given index. The given hot indices are compared first, 
+     * and their entries are called with a constant index, which the compiler turns into a direct call
+     */
+    template<typename Hot> struct hot_dispatch {};
+
+    template<> struct hot_dispatch<index_sequence<>>
+    {
+        template<typename R, typename Entry, size_t N, typename... Args>
+        static ONE_OF_CONSTEXPR14 R call(Entry const (&table)[N], uint32_t index, Args&&... args)
+        {
+            return table[index](std::forward<Args>(args)...);
+        }
+    };
+
+    template<size_t H, size_t... Hs> struct hot_dispatch<index_sequence<H, Hs...>>
+    {
+        template<typename R, typename Entry, size_t N, typename... Args>
+        static ONE_OF_CONSTEXPR14 R call(Entry const (&table)[N], uint32_t index, Args&&... args)
+        {
+            if (ONE_OF_LIKELY(index == H)) { return table[H](std::forward<Args>(args)...); }
+            return hot_dispatch<index_sequence<Hs...>>::template call<R>(table, index, std::forward<Args>(args)...);
+        }
+    };
+}}
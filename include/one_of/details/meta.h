@@ -0,0 +1,211 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+// Functions made of several statements can only be constexpr since C++14
+#if __cplusplus >= 201402L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+#define ONE_OF_CONSTEXPR14 constexpr
+#else
+#define ONE_OF_CONSTEXPR14
+#endif
+
+// True during constant evaluation, where what constant expressions forbid (memcmp, casts from void*...) must be avoided.
+// Without compiler support, visits and comparisons are not constant expressions
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define ONE_OF_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#elif (defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+#define ONE_OF_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#ifndef ONE_OF_IS_CONSTANT_EVALUATED
+#define ONE_OF_IS_CONSTANT_EVALUATED() false
+#endif
+
+namespace one_of {
+namespace details {
+
+    // -----------------------------------------------
+    // Type list
+    // -----------------------------------------------
+
+    template<typename... Ts>
+    struct type_list {};
+
+    template<typename T>
+    struct type_identity { typedef T type; };
+
+    template<typename... Ts> 
+    struct voider { typedef void type; };
+
+    // -----------------------------------------------
+    // Boolean folds
+    // -----------------------------------------------
+
+    template<bool... Bs> struct bool_pack {};
+    template<bool... Bs> struct all_of : std::is_same<bool_pack<true, Bs...>, bool_pack<Bs..., true>> {};
+
+    // The folds below split the range in two halves so that their recursion depth is logarithmic
+
+    // Index of the first element of values[from, to) equal to value, or to if there is none
+    constexpr uint32_t find_first(const bool* values, uint32_t from, uint32_t to, bool value);
+
+    constexpr uint32_t find_first_in_halves(const bool* values, uint32_t first_half, uint32_t middle, uint32_t to, bool value)
+    {
+        return first_half != middle ? first_half : find_first(values, middle, to, value);
+    }
+
+    constexpr uint32_t find_first(const bool* values, uint32_t from, uint32_t to, bool value)
+    {
+        return to - from == 0 ? to :
+               to - from == 1 ? (values[from] == value ? from : to) :
+               find_first_in_halves(values, find_first(values, from, from + (to - from) / 2, value), from + (to - from) / 2, to, value);
+    }
+
+    constexpr uint32_t find_first(const bool* values, uint32_t size, bool value)
+    {
+        return find_first(values, 0, size, value);
+    }
+
+    // Number of elements of values[from, to) equal to value
+    constexpr uint32_t count(const bool* values, uint32_t from, uint32_t to, bool value)
+    {
+        return to - from == 0 ? 0 :
+               to - from == 1 ? (values[from] == value ? 1 : 0) :
+               count(values, from, from + (to - from) / 2, value) + count(values, from + (to - from) / 2, to, value);
+    }
+
+    constexpr uint32_t count(const bool* values, uint32_t size, bool value)
+    {
+        return count(values, 0, size, value);
+    }
+
+    constexpr size_t larger(size_t a, size_t b)
+    {
+        return a > b ? a : b;
+    }
+
+    // Largest element of values[from, to), or 0 if the range is empty
+    constexpr size_t max_of(const size_t* values, uint32_t from, uint32_t to)
+    {
+        return to - from == 0 ? 0 :
+               to - from == 1 ? values[from] :
+               larger(max_of(values, from, from + (to - from) / 2), max_of(values, from + (to - from) / 2, to));
+    }
+
+    // Smallest multiple of alignment not lower than size
+    constexpr size_t round_up(size_t size, size_t alignment)
+    {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    // Index of the n-th (counting from 0) element of values[from, to) equal to value, which must exist
+    constexpr uint32_t find_nth(const bool* values, uint32_t from, uint32_t to, uint32_t n, bool value)
+    {
+        return to - from == 1 ? from :
+               count(values, from, from + (to - from) / 2, value) > n ? find_nth(values, from, from + (to - from) / 2, n, value) :
+               find_nth(values, from + (to - from) / 2, to, n - count(values, from, from + (to - from) / 2, value), value);
+    }
+
+    // -----------------------------------------------
+    // Index set
+    // -----------------------------------------------
+
+    // A set of indices, queried with a single flat expansion whatever its size
+    template<uint32_t... Is>
+    struct index_set
+    {
+        static constexpr uint32_t size = sizeof...(Is);
+
+        template<uint32_t I> struct contains : std::integral_constant<bool, !all_of<(Is != I)...>::value> {};
+        template<uint32_t I> using insert = index_set<Is..., I>;
+    };
+
+    // -----------------------------------------------
+    // Index sequence (std::index_sequence is C++14)
+    // -----------------------------------------------
+
+    template<size_t... Is>
+    struct index_sequence
+    {
+        static constexpr size_t size = sizeof...(Is);
+    };
+
+    template<typename S1, typename S2> struct concat_sequences {};
+    template<size_t... I1, size_t... I2> struct concat_sequences<index_sequence<I1...>, index_sequence<I2...>>
+    {
+        typedef index_sequence<I1..., (sizeof...(I1) + I2)...> type;
+    };
+
+    // Logarithmic instantiation depth : the sequence is built from two halves
+    template<size_t N> struct make_index_sequence_impl
+    {
+        typedef typename concat_sequences<
+            typename make_index_sequence_impl<N / 2>::type,
+            typename make_index_sequence_impl<N - N / 2>::type
+        >::type type;
+    };
+    template<> struct make_index_sequence_impl<0> { typedef index_sequence<> type; };
+    template<> struct make_index_sequence_impl<1> { typedef index_sequence<0> type; };
+
+    template<size_t N> using make_index_sequence = typename make_index_sequence_impl<N>::type;
+    template<typename... Ts> using index_sequence_for = make_index_sequence<sizeof...(Ts)>;
+
+    // -----------------------------------------------
+    // Tuple of references 
+    // -----------------------------------------------
+
+    // Unlike std::tuple, accessing an element does not instantiate one type per preceding element
+
+    template<size_t I, typename T> struct ref_leaf { T& ref; };
+
+    template<typename Indices, typename... Ts> struct ref_tuple_impl {};
+    template<size_t... Is, typename... Ts> struct ref_tuple_impl<index_sequence<Is...>, Ts...> : ref_leaf<Is, Ts>...
+    {
+        constexpr explicit ref_tuple_impl(Ts&... refs) : ref_leaf<Is, Ts>{refs}... {}
+    };
+
+    template<typename... Ts> using ref_tuple = ref_tuple_impl<index_sequence_for<Ts...>, Ts...>;
+
+    template<size_t I, typename T> constexpr T& get_ref(ref_leaf<I, T>& leaf) { return leaf.ref; }
+
+    // -----------------------------------------------
+    // Type at an index
+    // -----------------------------------------------
+
+    // Selected by overload resolution among the leaves, rather than by recursion over the preceding types
+
+    template<size_t I, typename T> struct type_leaf {};
+
+    template<typename Indices, typename... Ts> struct type_leaves {};
+    template<size_t... Is, typename... Ts> struct type_leaves<index_sequence<Is...>, Ts...> : type_leaf<Is, Ts>... {};
+
+    template<size_t I, typename T> type_identity<T> select_type(type_leaf<I, T>);
+
+    template<size_t I, typename... Ts> 
+    using type_at = typename decltype(select_type<I>(type_leaves<index_sequence_for<Ts...>, Ts...>()))::type;
+
+    // -----------------------------------------------
+    // Tuple of values
+    // -----------------------------------------------
+
+    template<size_t I, typename T> struct value_leaf { T value; };
+
+    template<typename Indices, typename... Ts> struct value_tuple_impl {};
+    template<size_t... Is, typename... Ts> struct value_tuple_impl<index_sequence<Is...>, Ts...> : value_leaf<Is, Ts>... {};
+
+    template<typename... Ts> using value_tuple = value_tuple_impl<index_sequence_for<Ts...>, Ts...>;
+
+    template<size_t I, typename T> T& get_value(value_leaf<I, T>& leaf)                 { return leaf.value; }
+    template<size_t I, typename T> const T& get_value(const value_leaf<I, T>& leaf)     { return leaf.value; }
+
+    // -----------------------------------------------
+    // Constness
+    // -----------------------------------------------
+
+    // T, with the const qualifier of From
+    template<typename From, typename T> struct copy_const             { typedef T type; };
+    template<typename From, typename T> struct copy_const<const From, T> { typedef const T type; };
+}}
@@ -0,0 +1,462 @@
+#pragma once
+
+#include "dispatch.h"
+#include "meta.h"
+#include "tagged_union.h"
+#include "../instrumentation.h"
+#include "../niche.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace one_of {
+namespace details {
+
+    // -----------------------------------------------
+    // Discriminant
+    // -----------------------------------------------
+
+    // Smallest unsigned integer able to hold the indices of N alternatives
+    template<uint32_t N> struct smallest_index
+    {
+        typedef typename std::conditional<(N <= (1u << 8)), uint8_t,
+                typename std::conditional<(N <= (1u << 16)), uint16_t, uint32_t>::type>::type type;
+    };
+
+    /**
+     * Describes whether the tag of a OneOf can be stored in the niches of one of its alternatives : 
+     * this is the case when exactly one alternative (the dataful one) is not empty, 
+     * and its type declares enough niches to encode all the other alternatives
+     */
+    template<typename... Tags>
+    struct niche_layout
+    {
+        static constexpr uint32_t size = sizeof...(Tags);
+
+        static constexpr bool empty_alternatives[size] = { std::is_empty<stored_type<Tags>>::value... };
+        static constexpr uint32_t dataful = find_first(empty_alternatives, size, false);
+
+        typedef typename std::tuple_element<(dataful < size ? dataful : 0), std::tuple<stored_type<Tags>...>>::type DatafulType;
+
+        static constexpr bool value = 
+            size > 1 &&
+            count(empty_alternatives, size, false) == 1 &&
+            niche_traits<DatafulType>::count >= size - 1;
+    };
+
+    template<typename... Tags> constexpr bool niche_layout<Tags...>::empty_alternatives[];
+
+    // The index is stored in the smallest possible integer
+    template<bool Niche, typename... Tags>
+    class DiscriminantStorage
+    {
+    protected:
+
+        DiscriminantStorage() = default;
+
+        template<uint32_t I>
+        constexpr explicit DiscriminantStorage(in_place_index<I>) : _index(static_cast<typename smallest_index<sizeof...(Tags)>::type>(I)) {}
+
+        constexpr uint32_t readIndex(const TaggedUnion<Tags...>&) const     { return _index; }
+        void writeIndex(TaggedUnion<Tags...>&, uint32_t index)              { _index = static_cast<typename smallest_index<sizeof...(Tags)>::type>(index); }
+        const void* indexAddress(const TaggedUnion<Tags...>&) const         { return &_index; }
+
+        typename smallest_index<sizeof...(Tags)>::type _index = 0;
+    };
+
+    // The index is encoded in the niches of the dataful alternative : 
+    // the i-th empty alternative is represented by the i-th niche
+    template<typename... Tags>
+    class DiscriminantStorage<true, Tags...>
+    {
+    protected:
+
+        typedef niche_layout<Tags...> Layout;
+        typedef niche_traits<typename Layout::DatafulType> Niches;
+
+        uint32_t readIndex(const TaggedUnion<Tags...>& value) const
+        {
+            const uint32_t niche = Niches::get(&value);
+            if (niche >= Layout::size - 1) { return Layout::dataful; }
+            return niche < Layout::dataful ? niche : niche + 1;
+        }
+
+        void writeIndex(TaggedUnion<Tags...>& value, uint32_t index)
+        {
+            if (index == Layout::dataful) { return; }
+            Niches::set(&value, index < Layout::dataful ? index : index - 1);
+        }
+
+        // The niches are somewhere in the payload
+        const void* indexAddress(const TaggedUnion<Tags...>& value) const { return &value; }
+    };
+
+    // The first alternative which is nothrow default constructible, or the number of alternatives if there is none
+    template<typename... Tags>
+    struct nothrow_fallback
+    {
+        static constexpr bool nothrow[sizeof...(Tags)] = { std::is_nothrow_default_constructible<stored_type<Tags>>::value... };
+        static constexpr uint32_t value = find_first(nothrow, sizeof...(Tags), true);
+    };
+
+    template<typename... Tags> constexpr bool nothrow_fallback<Tags...>::nothrow[];
+
+    // Copies are never constant expressions : the alternative is reached through its address, which instantiates less than the typed getters
+    template<typename T, typename V> void copy_alternative(V& var, const V& other)    { construct<T>(var, get_at<T>(static_cast<const void*>(&other))); }
+    template<typename T, typename V> void move_alternative(V& var, V& other)          { construct<T>(var, std::move(*reinterpret_cast<stored_type<T>*>(&other))); }
+
+    // Calls the construction hook from a constexpr constructor, which can not have a body before C++14. 
+    // The call is skipped when the instrumentation is disabled, so that the construction stays a constant expression
+    template<typename Instrumentation, uint32_t I>
+    constexpr in_place_index<I> notify_constructed(in_place_index<I> alternative)
+    {
+        return Instrumentation::enabled ? (Instrumentation::constructed(I), alternative) : alternative;
+    }
+
+    // -----------------------------------------------
+    // Storage of a OneOf : the tagged union and the index of its active member
+    // -----------------------------------------------
+
+    // Constructor tags of the storage : the payload is copied, or moved, from another storage of the same type,
+    // or converted from the payload of another OneOf type
+    struct copy_from {};
+    struct move_from {};
+    struct convert_from {};
+
+    template<typename... Tags>
+    class OneOfStorage : private DiscriminantStorage<niche_layout<Tags...>::value, Tags...>
+    {
+    protected:
+
+        typedef TaggedUnion<Tags...> Variant;
+        typedef DiscriminantStorage<niche_layout<Tags...>::value, Tags...> Discriminant;
+
+        OneOfStorage() = default;
+
+        // Constructs the I-th alternative. Constant expression, unless the index is stored in niches
+        template<uint32_t I, typename... Args>
+        constexpr explicit OneOfStorage(in_place_index<I> alternative, Args&&... args) : 
+            OneOfStorage(std::integral_constant<bool, niche_layout<Tags...>::value>(), alternative, std::forward<Args>(args)...) {}
+
+        // The payload is constructed by this layer, which has no destructor : if the copy or the move throws, 
+        // nothing is destroyed, whereas the destructor layer would destroy an alternative that was never constructed
+        OneOfStorage(copy_from, const OneOfStorage& other)
+        {
+            copyFrom(other._value, other.index());
+            setIndex(other.index());
+        }
+
+        OneOfStorage(move_from, OneOfStorage& other)
+        {
+            moveFrom(other._value, other.index());
+            setIndex(other.index());
+        }
+
+        template<typename Payload>
+        OneOfStorage(convert_from, void (*construct)(void*, Payload*), Payload* payload, uint32_t index)
+        {
+            construct(&_value, payload);
+            setIndex(index);
+        }
+
+        constexpr uint32_t index() const
+        {
+            return this->readIndex(_value);
+        }
+
+        // The offsets of the stored index (of the payload holding it in its niches) and of the payload, measured on 
+        // a storage holding no alternative : constructing it constructs no alternative, and it has no destructor
+        static size_t indexOffset()
+        {
+            const OneOfStorage storage;
+            return static_cast<size_t>(static_cast<const char*>(storage.Discriminant::indexAddress(storage._value)) - reinterpret_cast<const char*>(&storage));
+        }
+
+        static size_t payloadOffset()
+        {
+            const OneOfStorage storage;
+            return static_cast<size_t>(reinterpret_cast<const char*>(&storage._value) - reinterpret_cast<const char*>(&storage));
+        }
+
+        // Must be called after the alternative has been constructed, since it may write in its niches
+        void setIndex(uint32_t index)
+        {
+            this->writeIndex(_value, index);
+        }
+
+        // The active alternative is handled through tables of function pointers indexed by the index, 
+        // so the cost does not depend on the number of alternatives. Hot alternatives are checked before the table
+
+        // Trivially destructible alternatives are not destroyed : nothing is called when all of them are, 
+        // and a flag is checked before the table otherwise
+        void destructActive()
+        {
+            destructActive(all_trivially_destructible<Tags...>());
+        }
+
+        void destructActive(std::true_type) {}
+
+        void destructActive(std::false_type)
+        {
+            static constexpr bool trivial[] = { std::is_trivially_destructible<stored_type<Tags>>::value... };
+            const uint32_t active = index();
+            if (trivial[active]) { return; }
+
+            typedef void (*Destructor)(Variant&);
+            static constexpr Destructor destructors[] = { &destruct<Tags, Variant>... };
+            hot_dispatch<hot_indices<Tags...>>::template call<void>(destructors, active, _value);
+        }
+
+        void copyFrom(const Variant& other, uint32_t index)
+        {
+            typedef void (*Copier)(Variant&, const Variant&);
+            static constexpr Copier copiers[] = { &copy_alternative<Tags, Variant>... };
+            hot_dispatch<hot_indices<Tags...>>::template call<void>(copiers, index, _value, other);
+        }
+
+        void moveFrom(Variant& other, uint32_t index)
+        {
+            typedef void (*Mover)(Variant&, Variant&);
+            static constexpr Mover movers[] = { &move_alternative<Tags, Variant>... };
+            hot_dispatch<hot_indices<Tags...>>::template call<void>(movers, index, _value, other);
+        }
+
+        // Assignments and emplacements destroy the active alternative before constructing the new one. If that
+        // construction throws, the index must not name the destroyed alternative, which the destructor would destroy again :
+        //  - when the construction can not throw, the alternative is constructed in place
+        //  - otherwise, when the new payload can be moved without throwing, it is constructed aside then moved in place
+        //  - otherwise, the OneOf is left holding its first nothrow default constructible alternative
+
+        template<uint32_t I, typename... Args>
+        void emplaceAlternative(Args&&... args)
+        {
+            typedef stored_type<type_at<I, Tags...>> Stored;
+            emplaceAlternative<I>(std::integral_constant<int, 
+                std::is_nothrow_constructible<Stored, Args&&...>::value ? 0 : std::is_nothrow_move_constructible<Stored>::value ? 1 : 2>(), 
+                std::forward<Args>(args)...);
+        }
+
+        void copyAssign(const OneOfStorage& other)
+        {
+            copyAssign(other, std::integral_constant<int, 
+                all_of<std::is_nothrow_copy_constructible<stored_type<Tags>>::value...>::value ? 0 : 
+                all_of<std::is_nothrow_move_constructible<stored_type<Tags>>::value...>::value ? 1 : 2>());
+        }
+
+        void moveAssign(OneOfStorage& other)
+        {
+            moveAssign(other, std::integral_constant<bool, all_of<std::is_nothrow_move_constructible<stored_type<Tags>>::value...>::value>());
+        }
+
+        Variant _value;
+
+    private:
+
+        template<uint32_t I, typename... Args>
+        void emplaceAlternative(std::integral_constant<int, 0>, Args&&... args)
+        {
+            destructActive();
+            construct<type_at<I, Tags...>>(_value, std::forward<Args>(args)...);
+            setIndex(I);
+        }
+
+        template<uint32_t I, typename... Args>
+        void emplaceAlternative(std::integral_constant<int, 1>, Args&&... args)
+        {
+            stored_type<type_at<I, Tags...>> payload(std::forward<Args>(args)...);
+            destructActive();
+            construct<type_at<I, Tags...>>(_value, std::move(payload));
+            setIndex(I);
+        }
+
+        template<uint32_t I, typename... Args>
+        void emplaceAlternative(std::integral_constant<int, 2>, Args&&... args)
+        {
+            destructActive();
+            try { construct<type_at<I, Tags...>>(_value, std::forward<Args>(args)...); }
+            catch (...) { recover(); throw; }
+            setIndex(I);
+        }
+
+        void copyAssign(const OneOfStorage& other, std::integral_constant<int, 0>)
+        {
+            destructActive();
+            copyFrom(other._value, other.index());
+            setIndex(other.index());
+        }
+
+        void copyAssign(const OneOfStorage& other, std::integral_constant<int, 1>)
+        {
+            OneOfStorage copy(copy_from(), other);
+            destructActive();
+            moveFrom(copy._value, copy.index());
+            setIndex(copy.index());
+            copy.destructActive();
+        }
+
+        void copyAssign(const OneOfStorage& other, std::integral_constant<int, 2>)
+        {
+            destructActive();
+            try { copyFrom(other._value, other.index()); }
+            catch (...) { recover(); throw; }
+            setIndex(other.index());
+        }
+
+        void moveAssign(OneOfStorage& other, std::true_type)
+        {
+            destructActive();
+            moveFrom(other._value, other.index());
+            setIndex(other.index());
+        }
+
+        void moveAssign(OneOfStorage& other, std::false_type)
+        {
+            destructActive();
+            try { moveFrom(other._value, other.index()); }
+            catch (...) { recover(); throw; }
+            setIndex(other.index());
+        }
+
+        // Called once the active alternative has been destroyed, and the construction of the new one threw
+        void recover()
+        {
+            static constexpr uint32_t fallback = nothrow_fallback<Tags...>::value;
+            static_assert(fallback < sizeof...(Tags), 
+                "An alternative whose construction and move may both throw needs a nothrow default constructible alternative to fall back to");
+
+            construct<type_at<(fallback < sizeof...(Tags) ? fallback : 0), Tags...>>(_value);
+            setIndex(fallback);
+        }
+
+        template<uint32_t I, typename... Args>
+        constexpr OneOfStorage(std::false_type, in_place_index<I> alternative, Args&&... args) : 
+            Discriminant(alternative), 
+            _value(alternative, std::forward<Args>(args)...) {}
+
+        // The niches can only be written once the alternative has been constructed
+        template<uint32_t I, typename... Args>
+        OneOfStorage(std::true_type, in_place_index<I> alternative, Args&&... args) : 
+            _value(alternative, std::forward<Args>(args)...)
+        {
+            setIndex(I);
+        }
+    };
+
+    // -----------------------------------------------
+    // Destructor layer : trivial if all alternatives are trivially destructible
+    // -----------------------------------------------
+
+    template<bool TriviallyDestructible, typename... Tags>
+    class DestructibleStorage : public OneOfStorage<Tags...>
+    {
+    protected:
+
+        DestructibleStorage() = default;
+
+        template<uint32_t I, typename... Args>
+        explicit DestructibleStorage(in_place_index<I> alternative, Args&&... args) : 
+            OneOfStorage<Tags...>(alternative, std::forward<Args>(args)...) {}
+
+        DestructibleStorage(copy_from tag, const DestructibleStorage& other) : OneOfStorage<Tags...>(tag, other) {}
+        DestructibleStorage(move_from tag, DestructibleStorage& other) : OneOfStorage<Tags...>(tag, other) {}
+
+        template<typename Payload>
+        DestructibleStorage(convert_from tag, void (*construct)(void*, Payload*), Payload* payload, uint32_t index) : 
+            OneOfStorage<Tags...>(tag, construct, payload, index) {}
+
+        DestructibleStorage(const DestructibleStorage&) = default;
+        DestructibleStorage(DestructibleStorage&&) = default;
+        DestructibleStorage& operator=(const DestructibleStorage&) = default;
+        DestructibleStorage& operator=(DestructibleStorage&&) = default;
+
+        ~DestructibleStorage()
+        {
+            this->destructActive();
+        }
+    };
+
+    template<typename... Tags>
+    class DestructibleStorage<true, Tags...> : public OneOfStorage<Tags...>
+    {
+    protected:
+
+        DestructibleStorage() = default;
+
+        template<uint32_t I, typename... Args>
+        constexpr explicit DestructibleStorage(in_place_index<I> alternative, Args&&... args) : 
+            OneOfStorage<Tags...>(alternative, std::forward<Args>(args)...) {}
+
+        DestructibleStorage(copy_from tag, const DestructibleStorage& other) : OneOfStorage<Tags...>(tag, other) {}
+        DestructibleStorage(move_from tag, DestructibleStorage& other) : OneOfStorage<Tags...>(tag, other) {}
+
+        template<typename Payload>
+        DestructibleStorage(convert_from tag, void (*construct)(void*, Payload*), Payload* payload, uint32_t index) : 
+            OneOfStorage<Tags...>(tag, construct, payload, index) {}
+    };
+
+    // -----------------------------------------------
+    // Copy layer : trivial if all alternatives are trivially copyable, and copies are not instrumented
+    // -----------------------------------------------
+
+    template<bool TriviallyCopyable, typename... Tags>
+    class CopyableStorage : public DestructibleStorage<
+        all_of<std::is_trivially_destructible<stored_type<Tags>>::value...>::value, 
+        Tags...>
+    {
+    protected:
+
+        typedef DestructibleStorage<all_of<std::is_trivially_destructible<stored_type<Tags>>::value...>::value, Tags...> Base;
+
+        CopyableStorage() {}
+
+        template<uint32_t I, typename... Args>
+        constexpr explicit CopyableStorage(in_place_index<I> alternative, Args&&... args) : 
+            Base(alternative, std::forward<Args>(args)...) {}
+
+        template<typename Payload>
+        CopyableStorage(convert_from tag, void (*construct)(void*, Payload*), Payload* payload, uint32_t index) : 
+            Base(tag, construct, payload, index) {}
+
+        CopyableStorage(const CopyableStorage& other) : Base(copy_from(), other)
+        {
+            instrumentation<OneOf<Tags...>>::copied(other.index());
+        }
+
+        CopyableStorage(CopyableStorage&& other) noexcept(all_of<std::is_nothrow_move_constructible<stored_type<Tags>>::value...>::value) : 
+            Base(move_from(), other) {}
+
+        CopyableStorage& operator=(const CopyableStorage& other)
+        {
+            if (this == &other) { return *this; }
+            this->copyAssign(other);
+            instrumentation<OneOf<Tags...>>::copied(other.index());
+            return *this;
+        }
+
+        CopyableStorage& operator=(CopyableStorage&& other) noexcept(all_of<std::is_nothrow_move_constructible<stored_type<Tags>>::value...>::value)
+        {
+            if (this == &other) { return *this; }
+            this->moveAssign(other);
+            return *this;
+        }
+    };
+
+    template<typename... Tags>
+    class CopyableStorage<true, Tags...> : public DestructibleStorage<true, Tags...>
+    {
+    protected:
+
+        CopyableStorage() = default;
+
+        template<uint32_t I, typename... Args>
+        constexpr explicit CopyableStorage(in_place_index<I> alternative, Args&&... args) : 
+            DestructibleStorage<true, Tags...>(alternative, std::forward<Args>(args)...) {}
+
+        template<typename Payload>
+        CopyableStorage(convert_from tag, void (*construct)(void*, Payload*), Payload* payload, uint32_t index) : 
+            DestructibleStorage<true, Tags...>(tag, construct, payload, index) {}
+    };
+}}
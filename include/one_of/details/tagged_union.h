@@ -1,131 +1,235 @@
 #pragma once
 
+#include "meta.h"
+#include "../box.h"
+
 #include <stdint.h>
+#include <new>
+#include <type_traits>
 #include <utility>
 
 namespace one_of {
 namespace details {
-    
+
+    // -----------------------------------------------
+    // Storage of an alternative : inline, or boxed if its tag has a BoxAllocator
+    // -----------------------------------------------
+
+    template<typename Tag, typename Enable = void>
+    struct storage_traits
+    {
+        typedef typename Tag::Type Type;
+        typedef Type Stored;
+
+        static Type& get(void* address)                 { return *static_cast<Type*>(address); }
+        static const Type& get(const void* address)     { return *static_cast<const Type*>(address); }
+
+        static constexpr Type& from_stored(Stored& stored)              { return stored; }
+        static constexpr const Type& from_stored(const Stored& stored)  { return stored; }
+    };
+
+    template<typename Tag>
+    struct storage_traits<Tag, typename voider<typename Tag::BoxAllocator>::type>
+    {
+        typedef typename Tag::Type Type;
+        typedef Box<Type, typename Tag::BoxAllocator> Stored;
+
+        static Type& get(void* address)                 { return static_cast<Stored*>(address)->get(); }
+        static const Type& get(const void* address)     { return static_cast<const Stored*>(address)->get(); }
+
+        static Type& from_stored(Stored& stored)                        { return stored.get(); }
+        static const Type& from_stored(const Stored& stored)            { return stored.get(); }
+    };
+
+    template<typename Tag> using stored_type = typename storage_traits<Tag>::Stored;
+
     // -----------------------------------------------
     // Tagged Union Definition
     // -----------------------------------------------
 
-    template<typename HeadTag, typename... TailTags>
-    struct TaggedUnion
+    template<typename... Tags> struct TaggedUnion;
+
+    // Selects the member initialized by the constructor of a tagged union
+    template<uint32_t I> struct in_place_index {};
+
+    // The destructor is only user-provided when one of the members needs it,
+    // so that a union of trivially destructible types stays trivially destructible.
+    // The member is initialized by the constructor rather than with placement new, so that the union is usable in constant expressions
+    template<bool TriviallyDestructible, typename First, typename Second>
+    struct UnionStorage
     {
         union
         {
-            typename HeadTag::Type head;
-            TaggedUnion<TailTags...> tail;
+            First first;
+            Second second;
         };
 
-        TaggedUnion() {}
-        ~TaggedUnion() {}
+        UnionStorage() {}
+        ~UnionStorage() {}
+
+        template<typename... Args> explicit UnionStorage(std::true_type, Args&&... args) : first(std::forward<Args>(args)...) {}
+        template<typename... Args> explicit UnionStorage(std::false_type, Args&&... args) : second(std::forward<Args>(args)...) {}
     };
 
-    template<typename Tag>
-    struct TaggedUnion<Tag>
+    template<typename First, typename Second>
+    struct UnionStorage<true, First, Second>
     {
         union
         {
-            typename Tag::Type head;
-            uint8_t dummy;
+            First first;
+            Second second;
         };
-        
-        TaggedUnion() {}
-        ~TaggedUnion() {}
+
+        UnionStorage() {}
+
+        template<typename... Args> constexpr explicit UnionStorage(std::true_type, Args&&... args) : first(std::forward<Args>(args)...) {}
+        template<typename... Args> constexpr explicit UnionStorage(std::false_type, Args&&... args) : second(std::forward<Args>(args)...) {}
     };
 
-    // -----------------------------------------------
-    // Construct functions
-    // -----------------------------------------------
+    template<typename... Tags> struct all_trivially_destructible : all_of<std::is_trivially_destructible<stored_type<Tags>>::value...> {};
 
-    template<typename T, typename... Args> 
-    void construct(TaggedUnion<T>& var, Args&&... args);
+    // Splits the tags in two tagged unions, the first one holding N tags
+    template<uint32_t N, typename First, typename Rest> struct split_tags {};
 
-    template <typename U, typename T1, typename T2, typename... Ts, typename... Args> 
-    void construct(TaggedUnion<T1, T2, Ts...>& var, Args&&... args);
+    template<uint32_t N, typename... First, typename Next, typename... Rest> 
+    struct split_tags<N, type_list<First...>, type_list<Next, Rest...>> : split_tags<N - 1, type_list<First..., Next>, type_list<Rest...>> {};
 
-    template<typename T1, typename T2, typename... Ts>
-    class HeadConstructor
+    template<typename... First, typename Next, typename... Rest> 
+    struct split_tags<0, type_list<First...>, type_list<Next, Rest...>>
     {
-    public:
-        template<typename U, typename... Args>
-        static void construct(TaggedUnion<T1, T2, Ts...>& var, Args&&... args)
-        {
-            new (&var.head) (typename U::Type)(std::forward<Args>(args)...);
-        }
+        typedef TaggedUnion<First...> first;
+        typedef TaggedUnion<Next, Rest...> second;
     };
 
-    template<typename T1, typename T2, typename... Ts>
-    class TailConstructor
+    // The alternatives are split in two halves, recursively, so that reaching one of them only takes log2(N) steps
+    template<typename... Tags>
+    struct TaggedUnion : UnionStorage<
+        all_trivially_destructible<Tags...>::value,
+        typename split_tags<sizeof...(Tags) / 2, type_list<>, type_list<Tags...>>::first,
+        typename split_tags<sizeof...(Tags) / 2, type_list<>, type_list<Tags...>>::second
+    >
     {
-    public:
-        template<typename U, typename... Args>
-        static void construct(TaggedUnion<T1, T2, Ts...>& var, Args&&... args)
-        {
-            ::one_of::details::construct<U>(var.tail, args...);
-        }
+        static constexpr uint32_t first_size = sizeof...(Tags) / 2;
+
+        typedef split_tags<first_size, type_list<>, type_list<Tags...>> Halves;
+        typedef UnionStorage<all_trivially_destructible<Tags...>::value, typename Halves::first, typename Halves::second> Storage;
+
+        TaggedUnion() = default;
+
+        template<uint32_t I, typename... Args>
+        constexpr explicit TaggedUnion(in_place_index<I>, Args&&... args) : Storage(
+            std::integral_constant<bool, (I < first_size)>(), 
+            in_place_index<(I < first_size ? I : I - first_size)>(), 
+            std::forward<Args>(args)...) {}
     };
 
-    template<typename T, typename... Args> void construct(TaggedUnion<T>& var, Args&&... args)
+    template<typename Tag>
+    struct TaggedUnion<Tag> : UnionStorage<
+        std::is_trivially_destructible<stored_type<Tag>>::value,
+        stored_type<Tag>,
+        uint8_t
+    > 
     {
-        using Type = typename T::Type;
-        new (&var.head) Type(std::forward<Args>(args)...);
-    }
-        
-    template <typename U, typename T1, typename T2, typename... Ts, typename... Args> void construct(TaggedUnion<T1, T2, Ts...>& var, Args&&... args)
+        typedef UnionStorage<std::is_trivially_destructible<stored_type<Tag>>::value, stored_type<Tag>, uint8_t> Storage;
+
+        TaggedUnion() = default;
+
+        template<typename... Args>
+        constexpr explicit TaggedUnion(in_place_index<0>, Args&&... args) : Storage(std::true_type(), std::forward<Args>(args)...) {}
+    };
+
+    // -----------------------------------------------
+    // Utils
+    // -----------------------------------------------
+
+    template<typename V> struct size_of {};
+    template<typename... Ts> struct size_of<TaggedUnion<Ts...>> { static constexpr uint32_t value = sizeof...(Ts); };
+
+    template<typename T, typename V> struct index_of {};
+    template<typename T, typename... Ts> struct index_of<T, TaggedUnion<Ts...>>
     {
-        std::conditional<   
-            std::is_same<U,T1>::value, 
-            HeadConstructor<T1, T2, Ts...>, 
-            TailConstructor<T1, T2, Ts...>
-        >::type::template construct<U>(var, args...);
-    }
+        static constexpr bool matches[sizeof...(Ts)] = { std::is_same<T, Ts>::value... };
+        static constexpr uint32_t value = find_first(matches, sizeof...(Ts), true);
+        static_assert(value < sizeof...(Ts), "This tag is not an alternative of this OneOf");
+    };
+
+    template<typename T, typename... Ts> constexpr bool index_of<T, TaggedUnion<Ts...>>::matches[];
 
     // -----------------------------------------------
-    // Destruct Functions
+    // Getters
     // -----------------------------------------------
 
-    template<typename U, typename T, typename... Ts> void destruct(TaggedUnion<T, Ts...>& var)
+    // All the members of the (nested) union live at the address of the tagged union, 
+    // so accessing any of them does not require to walk through the halves
+
+    template<typename T>                typename T::Type& get_at(void* address)              { return storage_traits<T>::get(address); }
+    template<typename T>                const typename T::Type& get_at(const void* address)  { return storage_traits<T>::get(address); }
+
+    // Constant expressions can not reach a member through a cast address : during constant evaluation, 
+    // the typed getters walk down the halves instead
+    template<typename T, uint32_t I>
+    struct member_at
     {
-        if (std::is_same<U, T>::value)
+        static constexpr stored_type<T>& get(TaggedUnion<T>& leaf)                 { return leaf.first; }
+        static constexpr const stored_type<T>& get(const TaggedUnion<T>& leaf)     { return leaf.first; }
+
+        template<typename U>
+        static constexpr typename copy_const<U, stored_type<T>>::type& get(U& node)
         {
-            using Type = typename T::Type;
-            var.head.~Type();
+            return get_half(node, std::integral_constant<bool, (I < std::remove_const<U>::type::first_size)>());
         }
-        else
+
+    private:
+
+        template<typename U>
+        static constexpr typename copy_const<U, stored_type<T>>::type& get_half(U& node, std::true_type)
         {
-            destruct<U>(var.tail);
+            return member_at<T, I>::get(node.first);
         }
+
+        template<typename U>
+        static constexpr typename copy_const<U, stored_type<T>>::type& get_half(U& node, std::false_type)
+        {
+            return member_at<T, I - std::remove_const<U>::type::first_size>::get(node.second);
+        }
+    };
+
+    template<typename T, typename... Ts>
+    constexpr typename T::Type& get_at(TaggedUnion<Ts...>* var)
+    {
+        return ONE_OF_IS_CONSTANT_EVALUATED() ? 
+            storage_traits<T>::from_stored(member_at<T, index_of<T, TaggedUnion<Ts...>>::value>::get(*var)) : 
+            storage_traits<T>::get(static_cast<void*>(var));
     }
 
-    template<typename U, typename T> void destruct(TaggedUnion<T>& var)
+    template<typename T, typename... Ts>
+    constexpr const typename T::Type& get_at(const TaggedUnion<Ts...>* var)
     {
-        using Type = typename T::Type;
-        var.head.~Type();
+        return ONE_OF_IS_CONSTANT_EVALUATED() ? 
+            storage_traits<T>::from_stored(member_at<T, index_of<T, TaggedUnion<Ts...>>::value>::get(*var)) : 
+            storage_traits<T>::get(static_cast<const void*>(var));
     }
 
+    template<typename T, typename V>    constexpr typename T::Type& get(V& var)              { return get_at<T>(&var); }
+    template<typename T, typename V>    constexpr const typename T::Type& get(const V& var)  { return get_at<T>(&var); }
+
     // -----------------------------------------------
-    // Getters
+    // Construct functions
     // -----------------------------------------------
 
-    template<typename T, typename... Ts>    typename T::Type& get(TaggedUnion<T, Ts...>& var)                { return var.head; }
-    template<typename T, typename... Ts>    typename T::Type& get(TaggedUnion<Ts...>& var)                   { return get<T>(var.tail); }
-
-    template<typename T, typename... Ts>    const typename T::Type& get(const TaggedUnion<T, Ts...>& var)    { return var.head; }
-    template<typename T, typename... Ts>    const typename T::Type& get(const TaggedUnion<Ts...>& var)       { return get<T>(var.tail); }
+    template<typename T, typename V, typename... Args> void construct(V& var, Args&&... args)
+    {
+        using Stored = stored_type<T>;
+        new (static_cast<void*>(&var)) Stored(std::forward<Args>(args)...);
+    }
 
     // -----------------------------------------------
-    // Utils
+    // Destruct Functions
     // -----------------------------------------------
 
-    template<typename V> struct size_of{};
-    template<typename T>                    struct size_of<TaggedUnion<T>>        { static constexpr uint32_t value = 1; };
-    template<typename T, typename... Ts>    struct size_of<TaggedUnion<T, Ts...>> { static constexpr uint32_t value = 1 + size_of<TaggedUnion<Ts...>>::value; };
-
-    template<typename T, typename V>                    struct index_of {};
-    template<typename T>                                struct index_of<T, TaggedUnion<T>>            { static constexpr uint32_t value = 0; };
-    template<typename T, typename... Ts>                struct index_of<T, TaggedUnion<T, Ts...>>     { static constexpr uint32_t value = 0; };
-    template<typename U, typename T, typename... Ts>    struct index_of<U, TaggedUnion<T, Ts...>>     { static constexpr uint32_t value =  1 + index_of<U, TaggedUnion<Ts...>>::value; };
+    template<typename T, typename V> void destruct(V& var)
+    {
+        using Stored = stored_type<T>;
+        reinterpret_cast<Stored*>(&var)->~Stored();
+    }
 }}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <typeinfo>
+
+#if defined(__GNUG__)
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
+
+namespace one_of {
+namespace details {
+
+    // The readable name of a type, demangled when the compiler allows it
+    template<typename T>
+    std::string type_name()
+    {
+#if defined(__GNUG__)
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(typeid(T).name(), nullptr, nullptr, &status);
+        if (status == 0 && demangled != nullptr)
+        {
+            const std::string name(demangled);
+            std::free(demangled);
+            return name;
+        }
+#endif
+        return typeid(T).name();
+    }
+}}
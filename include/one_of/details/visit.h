@@ -0,0 +1,80 @@
+#pragma once
+
+#include "dispatch.h"
+#include "meta.h"
+#include "tagged_union.h"
+
+#include <stdint.h>
+#include <type_traits>
+#include <utility>
+
+namespace one_of {
+namespace details {
+
+    // -----------------------------------------------
+    // Result type of a visit
+    // -----------------------------------------------
+
+    // std::common_type is recursive, skip it in the usual case where all handlers return the same type
+    template<typename R, typename... Rs> struct common_type_of : std::conditional<
+        all_of<std::is_same<R, Rs>::value...>::value, 
+        type_identity<R>, 
+        std::common_type<R, Rs...>
+    >::type {};
+
+    // Has no "type" member if one of the calls is invalid, so that the overload is discarded
+    template<typename Void, typename... Calls> struct common_result {};
+    template<typename... Calls> 
+    struct common_result<typename voider<typename std::result_of<Calls>::type...>::type, Calls...> 
+        : common_type_of<typename std::result_of<Calls>::type...> {};
+
+    template<bool SameSize, typename Args, typename Handlers> 
+    struct visit_result_impl 
+    { 
+        static_assert(SameSize, "visit expects exactly one handler per alternative"); 
+        typedef void type;
+    };
+
+    template<typename... Args, typename... Handlers> 
+    struct visit_result_impl<true, type_list<Args...>, type_list<Handlers...>> 
+        : common_result<void, Handlers&(Args)...> {};
+
+    template<typename Args, typename Handlers> struct visit_result {};
+    template<typename... Args, typename... Handlers> struct visit_result<type_list<Args...>, type_list<Handlers...>>
+        : visit_result_impl<sizeof...(Args) == sizeof...(Handlers), type_list<Args...>, type_list<Handlers...>> {};
+
+    // -----------------------------------------------
+    // Jump table dispatch
+    // -----------------------------------------------
+
+    template<typename R, typename P, typename Tag, size_t I, typename HandlerTuple>
+    ONE_OF_CONSTEXPR14 R visit_alternative(P* payload, HandlerTuple& handlers)
+    {
+        return get_ref<I>(handlers)(get_at<Tag>(payload));
+    }
+
+    // A class member rather than a local static, which constexpr functions can not declare
+    template<typename R, typename P, typename HandlerTuple, typename Tags, typename Indices> struct visit_table {};
+    template<typename R, typename P, typename HandlerTuple, typename... Tags, size_t... Is> 
+    struct visit_table<R, P, HandlerTuple, type_list<Tags...>, index_sequence<Is...>>
+    {
+        typedef R (*Entry)(P*, HandlerTuple&);
+        static constexpr Entry entries[] = { &visit_alternative<R, P, Tags, Is, HandlerTuple>... };
+    };
+
+    template<typename R, typename P, typename HandlerTuple, typename... Tags, size_t... Is> 
+    constexpr typename visit_table<R, P, HandlerTuple, type_list<Tags...>, index_sequence<Is...>>::Entry 
+    visit_table<R, P, HandlerTuple, type_list<Tags...>, index_sequence<Is...>>::entries[];
+
+    /**
+     * Calls the I-th handler with the I-th alternative stored at the given address, where I is the given index.
+     * The handler is selected through a table of function pointers, so the cost 
+     * does not depend on the number of alternatives. Hot alternatives are checked before the table
+     */
+    template<typename R, typename P, typename... Tags, size_t... Is, typename HandlerTuple>
+    ONE_OF_CONSTEXPR14 R visit(P* payload, const uint32_t& index, type_list<Tags...>, index_sequence<Is...>, HandlerTuple& handlers)
+    {
+        return hot_dispatch<hot_indices<Tags...>>::template call<R>(
+            visit_table<R, P, HandlerTuple, type_list<Tags...>, index_sequence<Is...>>::entries, index, payload, handlers);
+    }
+}}
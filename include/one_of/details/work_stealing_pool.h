@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace one_of
+{
+namespace details
+{
+    /**
+     * A pool of threads, each with its own queue of tasks. Tasks are submitted to the queues in turn,
+     * and a thread whose queue is empty steals the most recently submitted task of another queue.
+     * Pending tasks are run before the pool is destroyed
+     */
+    class WorkStealingPool
+    {
+    public:
+
+        typedef std::function<void()> Task;
+
+        explicit WorkStealingPool(size_t thread_count) : _next(0), _pending(0), _stopping(false)
+        {
+            if (thread_count == 0) { thread_count = 1; }
+            for (size_t i = 0; i < thread_count; ++i) { _queues.emplace_back(new Queue()); }
+            for (size_t i = 0; i < thread_count; ++i) { _threads.emplace_back(&WorkStealingPool::work, this, i); }
+        }
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        ~WorkStealingPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stopping = true;
+            }
+            _wake.notify_all();
+            for (std::thread& thread : _threads) { thread.join(); }
+        }
+
+        size_t size() const { return _threads.size(); }
+
+        void submit(Task task)
+        {
+            Queue& queue = *_queues[_next.fetch_add(1, std::memory_order_relaxed) % _queues.size()];
+            {
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.tasks.push_back(std::move(task));
+            }
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                ++_pending;
+            }
+            _wake.notify_one();
+        }
+
+    private:
+
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        // Takes the oldest task of its own queue, or the newest task of another queue
+        bool pop(size_t self, Task& task)
+        {
+            for (size_t i = 0; i < _queues.size(); ++i)
+            {
+                Queue& queue = *_queues[(self + i) % _queues.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (queue.tasks.empty()) { continue; }
+
+                if (i == 0)
+                {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+                else
+                {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                }
+                return true;
+            }
+            return false;
+        }
+
+        void work(size_t self)
+        {
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _wake.wait(lock, [this]() { return _pending > 0 || _stopping; });
+                    if (_pending == 0) { return; }
+                    --_pending;
+                }
+
+                // The task counted by _pending is in one of the queues
+                Task task;
+                while (!pop(self, task)) { std::this_thread::yield(); }
+                task();
+            }
+        }
+
+        std::vector<std::unique_ptr<Queue>> _queues;
+        std::atomic<size_t> _next;
+
+        std::mutex _mutex;
+        std::condition_variable _wake;
+        size_t _pending;
+        bool _stopping;
+
+        std::vector<std::thread> _threads;
+    };
+
+    /**
+     * The pool shared by the calls of parallel_visit_batch, created on first use 
+     * with one thread per hardware thread, besides the calling thread
+     */
+    inline WorkStealingPool& shared_pool()
+    {
+        static WorkStealingPool pool(std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1);
+        return pool;
+    }
+}
+}
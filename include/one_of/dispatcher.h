@@ -0,0 +1,145 @@
+#pragma once
+
+#include "one_of.h"
+#include "details/work_stealing_pool.h"
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace one_of
+{
+namespace details
+{
+    template<typename Result>
+    struct Registration
+    {
+        size_t thread_count;
+        std::function<Result(void*)> handler;
+    };
+
+    // Owns the dispatched OneOf until its handler has run
+    template<typename Result, typename Value>
+    struct DispatchJob
+    {
+        const std::function<Result(void*)>* handler;
+        Value value;
+
+        Result operator()() { return (*handler)(OneOfAccess::payload(value)); }
+    };
+}
+
+    template<typename Result, typename... Tags> class Dispatcher;
+
+    /**
+     * Registers the handlers of a Dispatcher, one per tag
+     * @tparam Result the type returned by the handlers
+     * @tparam Matched the set of the indices of the tags that have already been registered
+     * @tparam Tags the tags of the dispatched OneOfs
+     */
+    template<typename Result, typename Matched, typename... Tags>
+    class DispatcherBuilder
+    {
+    public:
+
+        typedef details::TaggedUnion<Tags...> Variant;
+
+        /**
+         * Registers the handler of a tag
+         * @tparam Tag the tag to handle
+         * @param thread_count the number of threads running this handler
+         * @param handler the function, called with the value of the alternative, that computes the result.
+         *        It may be called by several threads at once, unless thread_count is 1 : only then can it safely keep a state
+         * @return A builder for chained calls
+         */
+        template<typename Tag, typename Handler>
+        DispatcherBuilder<Result, typename Matched::template insert<details::index_of<Tag, Variant>::value>, Tags...>
+        on(size_t thread_count, Handler handler)
+        {
+            static_assert(!Matched::template contains<details::index_of<Tag, Variant>::value>::value, "Can not register the same tag twice");
+
+            _registrations[details::index_of<Tag, Variant>::value] = details::Registration<Result>{
+                thread_count,
+                [handler](void* payload) mutable -> Result { return handler(details::get_at<Tag>(payload)); }
+            };
+            return DispatcherBuilder<Result, typename Matched::template insert<details::index_of<Tag, Variant>::value>, Tags...>(std::move(_registrations));
+        }
+
+        /**
+         * Starts the worker threads. All tags must have been registered
+         */
+        std::unique_ptr<Dispatcher<Result, Tags...>> build()
+        {
+            static_assert(Matched::size == details::size_of<Variant>::value, "Dispatcher is not exhaustive : register a handler for each tag");
+            return std::unique_ptr<Dispatcher<Result, Tags...>>(new Dispatcher<Result, Tags...>(std::move(_registrations)));
+        }
+
+    private:
+
+        template<typename, typename, typename...> friend class DispatcherBuilder;
+        friend class Dispatcher<Result, Tags...>;
+
+        explicit DispatcherBuilder(std::vector<details::Registration<Result>> registrations) : _registrations(std::move(registrations)) {}
+
+        std::vector<details::Registration<Result>> _registrations;
+    };
+
+    /**
+     * Runs the handler of each submitted OneOf on the pool of threads of its alternative,
+     * so that slow alternatives do not delay the others
+     * @tparam Result the type returned by the handlers
+     * @tparam Tags the tags of the dispatched OneOfs
+     */
+    template<typename Result, typename... Tags>
+    class Dispatcher
+    {
+    public:
+
+        typedef OneOf<Tags...> value_type;
+
+        /**
+         * @return a builder on which each tag must be registered, before building the Dispatcher
+         */
+        static DispatcherBuilder<Result, details::index_set<>, Tags...> builder()
+        {
+            return DispatcherBuilder<Result, details::index_set<>, Tags...>(std::vector<details::Registration<Result>>(sizeof...(Tags)));
+        }
+
+        Dispatcher(const Dispatcher&) = delete;
+        Dispatcher& operator=(const Dispatcher&) = delete;
+
+        /**
+         * Queues a OneOf on the pool of its alternative
+         * @param value the OneOf, owned by the Dispatcher until its handler has run
+         * @return the result of the handler, or the exception it threw
+         */
+        std::future<Result> submit(value_type value)
+        {
+            const uint32_t index = value.index();
+            std::shared_ptr<std::packaged_task<Result()>> task = std::make_shared<std::packaged_task<Result()>>(
+                details::DispatchJob<Result, value_type>{&_registrations[index].handler, std::move(value)});
+
+            std::future<Result> result = task->get_future();
+            _pools[index]->submit([task]() { (*task)(); });
+            return result;
+        }
+
+    private:
+
+        template<typename, typename, typename...> friend class DispatcherBuilder;
+
+        explicit Dispatcher(std::vector<details::Registration<Result>> registrations) : _registrations(std::move(registrations))
+        {
+            for (const details::Registration<Result>& registration : _registrations)
+            {
+                _pools.emplace_back(new details::WorkStealingPool(registration.thread_count));
+            }
+        }
+
+        // The pools are destroyed first, running their pending tasks while the handlers still exist
+        std::vector<details::Registration<Result>> _registrations;
+        std::vector<std::unique_ptr<details::WorkStealingPool>> _pools;
+    };
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "one_of.h"
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace one_of
+{
+namespace details
+{
+    // Finalizer of splitmix64 : every bit of the input affects every bit of the output
+    inline uint64_t mix(uint64_t value)
+    {
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    // Constant sizes let the compiler replace memcpy by a single load
+    inline uint64_t load_word(const char* bytes, size_t size)
+    {
+        uint64_t word = 0;
+        switch (size)
+        {
+            case 1: memcpy(&word, bytes, 1); break;
+            case 2: memcpy(&word, bytes, 2); break;
+            case 4: memcpy(&word, bytes, 4); break;
+            case 8: memcpy(&word, bytes, 8); break;
+            default: memcpy(&word, bytes, size); break;
+        }
+        return word;
+    }
+
+    // Payloads of up to 8 bytes are returned as is : they are mixed with the index by hash_value
+    inline uint64_t hash_bytes(const void* data, size_t size)
+    {
+        const char* bytes = static_cast<const char*>(data);
+        if (size <= sizeof(uint64_t)) { return load_word(bytes, size); }
+
+        uint64_t hash = size;
+        for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), bytes += sizeof(uint64_t))
+        {
+            hash = mix(hash ^ load_word(bytes, sizeof(uint64_t)));
+        }
+        if (size > 0) { hash = mix(hash ^ load_word(bytes, size)); }
+        return hash;
+    }
+
+    template<typename Tag> 
+    uint64_t hash_alternative(const void* payload)
+    {
+        return std::hash<typename Tag::Type>()(get_at<Tag>(payload));
+    }
+
+    template<typename... Tags>
+    uint64_t hash_payload(const void* payload, uint32_t index, std::true_type)
+    {
+        return hash_bytes(payload, payload_sizes<Tags...>::values[index]);
+    }
+
+    template<typename... Tags>
+    uint64_t hash_payload(const void* payload, uint32_t index, std::false_type)
+    {
+        typedef uint64_t (*Entry)(const void*);
+        static constexpr Entry table[] = { &hash_alternative<Tags>... };
+        return table[index](payload);
+    }
+}
+
+    /**
+     * Hashes the index of a OneOf with its payload : with std::hash for the payload, 
+     * or from the bytes of the payload when all alternatives are trivially comparable
+     */
+    template<typename... Tags>
+    size_t hash_value(const OneOf<Tags...>& value)
+    {
+        const uint64_t payload_hash = details::hash_payload<Tags...>(
+            details::OneOfAccess::payload(value), value.index(), details::all_trivially_comparable<Tags...>());
+        return static_cast<size_t>(details::mix(payload_hash + value.index() * 0x9E3779B97F4A7C15ull));
+    }
+}
+
+namespace std
+{
+    template<typename... Tags>
+    struct hash<one_of::OneOf<Tags...>>
+    {
+        size_t operator()(const one_of::OneOf<Tags...>& value) const { return one_of::hash_value(value); }
+    };
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <type_traits>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ONE_OF_LIKELY(condition) __builtin_expect(!!(condition), 1)
+#else
+#define ONE_OF_LIKELY(condition) (condition)
+#endif
+
+namespace one_of
+{
+    /**
+     * Declares that an alternative dominates the traffic. Destruction, copies, moves and visits of the OneOfs 
+     * check the hot alternatives first, in the order of the tags, and call them directly (so they can be inlined) 
+     * instead of going through a table of function pointers. Matching a hot tag is marked as likely.
+     * 
+     * Each hot alternative adds a comparison in front of the table for the other ones : keep it to a few tags.
+     * one_of::write_hot_alternatives (counters.h) generates these specializations from measured counts.
+     * @tparam Tag the tag of the alternative
+     */
+    template<typename Tag>
+    struct is_hot : std::false_type {};
+}
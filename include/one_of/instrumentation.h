@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace one_of
+{
+    template<typename... Tags> class OneOf;
+
+    /**
+     * Hooks that do nothing : the default instrumentation of all OneOf types, which compiles to no code.
+     * 
+     * Instrumentations must provide :
+     *  - static constexpr bool enabled : false only for instrumentations whose hooks do nothing,
+     *    true keeps copies of trivially copyable OneOfs observable (they are no longer trivially copyable)
+     *  - static void constructed(uint32_t index) : a OneOf has been constructed with the given alternative
+     *  - static void emplaced(uint32_t index) : the given alternative has been emplaced in a OneOf
+     *  - static void copied(uint32_t index) : a OneOf holding the given alternative has been copied
+     *  - typedef ... Timer, static Timer beginMatch(uint32_t index), static void endMatch(uint32_t index, const Timer&) : 
+     *    called around the handler that matched the given alternative, in match and visit
+     */
+    struct NoInstrumentation
+    {
+        static constexpr bool enabled = false;
+
+        struct Timer {};
+
+        static void constructed(uint32_t) {}
+        static void emplaced(uint32_t) {}
+        static void copied(uint32_t) {}
+        static Timer beginMatch(uint32_t) { return Timer(); }
+        static void endMatch(uint32_t, const Timer&) {}
+    };
+
+    /**
+     * The instrumentation of a OneOf type. Specialize it, before the OneOf type is used, to observe the OneOfs of this type :
+     *     template<> struct instrumentation<MyOneOf> : one_of::Counters<MyOneOf> {};
+     * @tparam O the OneOf type
+     */
+    template<typename O>
+    struct instrumentation : NoInstrumentation {};
+
+namespace details
+{
+    template<typename V> struct one_of_of {};
+
+    // Calls the end hook of the instrumentation when the handler returns, or throws
+    template<typename O, bool Enabled = instrumentation<O>::enabled>
+    class MatchScope
+    {
+    public:
+
+        explicit MatchScope(uint32_t index) : _index(index), _timer(instrumentation<O>::beginMatch(index)) {}
+        ~MatchScope() { instrumentation<O>::endMatch(_index, _timer); }
+
+    private:
+
+        const uint32_t _index;
+        const typename instrumentation<O>::Timer _timer;
+    };
+
+    // Without instrumentation, the scope is a literal type, so that visits can be constant expressions
+    template<typename O>
+    class MatchScope<O, false>
+    {
+    public:
+
+        constexpr explicit MatchScope(uint32_t) {}
+    };
+}
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "one_of.h"
+#include "details/meta.h"
+#include "details/storage.h"
+#include "details/type_name.h"
+
+#include <iomanip>
+#include <ostream>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Fails the build if the OneOf type is larger than the given number of bytes. The instantiation of
+// details::alternative_within_budget reported with the error names the alternatives that do not fit
+#define ONE_OF_ASSERT_SIZE_AT_MOST(type, bytes) \
+    static_assert(::one_of::details::within_budget<type, bytes>::value, "sizeof(" #type ") exceeds " #bytes " bytes")
+
+#define ONE_OF_LAYOUT_CONCAT_IMPL(a, b) a##b
+#define ONE_OF_LAYOUT_CONCAT(a, b) ONE_OF_LAYOUT_CONCAT_IMPL(a, b)
+
+// Registers the layout of the OneOf type, so that it is part of one_of::layout_reports. At namespace scope
+#define ONE_OF_REPORT_LAYOUT(type) \
+    static const bool ONE_OF_LAYOUT_CONCAT(one_of_layout_registered_, __LINE__) = ::one_of::details::register_layout<type>(#type);
+
+namespace one_of
+{
+    /**
+     * The layout of a OneOf type. The sizes are known at compile time, and are the sizes stored inline :
+     * the size of a pointer for boxed alternatives. The offsets are measured
+     * @tparam O the OneOf type
+     */
+    template<typename O> struct layout;
+
+    template<typename... Tags>
+    struct layout<OneOf<Tags...>>
+    {
+        static constexpr uint32_t alternatives = sizeof...(Tags);
+
+        static constexpr size_t sizes[sizeof...(Tags)] = { sizeof(details::stored_type<Tags>)... };
+        static constexpr size_t alignments[sizeof...(Tags)] = { alignof(details::stored_type<Tags>)... };
+
+        static constexpr size_t size = sizeof(OneOf<Tags...>);
+        static constexpr size_t alignment = alignof(OneOf<Tags...>);
+
+        // With a niche layout, the index is encoded in the niches of the dataful alternative and takes no byte of its own
+        static constexpr bool niche = details::niche_layout<Tags...>::value;
+        static constexpr size_t discriminant_size = niche ? 0 : sizeof(typename details::smallest_index<sizeof...(Tags)>::type);
+
+        // The offsets are measured by the storage, so they do not depend on how the compiler lays it out. 
+        // With a niche layout, the discriminant is reported at the payload
+        static size_t discriminant_offset()  { return details::OneOfAccess::index_offset<Tags...>(); }
+        static size_t payload_offset()       { return details::OneOfAccess::payload_offset<Tags...>(); }
+
+        static constexpr size_t largest = details::max_of(sizes, 0, sizeof...(Tags));
+
+        // The bytes holding neither the discriminant nor the payload, when the largest alternative is active
+        static constexpr size_t padding = size - discriminant_size - largest;
+
+        // The bytes holding neither the discriminant nor the payload, when each alternative is active
+        static constexpr size_t unused[sizeof...(Tags)] = { size - discriminant_size - sizeof(details::stored_type<Tags>)... };
+
+        // The size the OneOf would have if each alternative was the only one not empty
+        static constexpr size_t footprints[sizeof...(Tags)] = {
+            niche ? sizeof(details::stored_type<Tags>) : details::round_up(
+                details::round_up(discriminant_size, alignof(details::stored_type<Tags>)) + sizeof(details::stored_type<Tags>),
+                details::larger(alignof(details::stored_type<Tags>), discriminant_size))...
+        };
+    };
+
+    template<typename... Tags> constexpr size_t layout<OneOf<Tags...>>::sizes[];
+    template<typename... Tags> constexpr size_t layout<OneOf<Tags...>>::alignments[];
+    template<typename... Tags> constexpr size_t layout<OneOf<Tags...>>::unused[];
+    template<typename... Tags> constexpr size_t layout<OneOf<Tags...>>::footprints[];
+
+    struct AlternativeLayout
+    {
+        std::string tag;
+        size_t size;
+        size_t alignment;
+        size_t unused;
+    };
+
+    /**
+     * The layout of a OneOf type, to print
+     */
+    struct LayoutReport
+    {
+        std::string type;
+        size_t size;
+        size_t alignment;
+        bool niche;
+        size_t discriminant_offset;
+        size_t discriminant_size;
+        size_t padding;
+        std::vector<AlternativeLayout> alternatives;
+    };
+
+    inline std::ostream& operator<<(std::ostream& out, const LayoutReport& report)
+    {
+        out << report.type << " : size=" << report.size << " align=" << report.alignment;
+        if (report.niche) { out << " discriminant=niche"; }
+        else { out << " discriminant=" << report.discriminant_size << "@" << report.discriminant_offset; }
+        out << " padding=" << report.padding << "\n";
+
+        for (const AlternativeLayout& alternative : report.alternatives)
+        {
+            out << "  " << std::left << std::setw(32) << alternative.tag << std::right
+                << " size=" << std::setw(6) << alternative.size
+                << " align=" << std::setw(3) << alternative.alignment
+                << " unused=" << std::setw(6) << alternative.unused << "\n";
+        }
+        return out;
+    }
+
+namespace details
+{
+    template<typename Layout, typename... Tags>
+    void add_alternative_layouts(LayoutReport& report, type_list<Tags...>)
+    {
+        const std::string tags[] = { type_name<Tags>()... };
+        for (uint32_t i = 0; i < sizeof...(Tags); ++i)
+        {
+            report.alternatives.push_back(AlternativeLayout{ tags[i], Layout::sizes[i], Layout::alignments[i], Layout::unused[i] });
+        }
+    }
+}
+
+    /**
+     * @tparam O the OneOf type
+     * @param type the name to report, the demangled name of the type if null
+     * @return the layout of the OneOf type
+     */
+    template<typename O>
+    LayoutReport layout_report(const char* type = nullptr)
+    {
+        typedef layout<O> Layout;
+        typedef typename details::tags_of<O>::type Tags;
+
+        LayoutReport report;
+        report.type = type != nullptr ? std::string(type) : details::type_name<O>();
+        report.size = Layout::size;
+        report.alignment = Layout::alignment;
+        report.niche = Layout::niche;
+        report.discriminant_offset = Layout::discriminant_offset();
+        report.discriminant_size = Layout::discriminant_size;
+        report.padding = Layout::padding;
+        details::add_alternative_layouts<Layout>(report, Tags());
+        return report;
+    }
+
+namespace details
+{
+    // The layouts of the types registered with ONE_OF_REPORT_LAYOUT
+    struct LayoutRegistry
+    {
+        std::vector<LayoutReport> reports;
+
+        static LayoutRegistry& instance()
+        {
+            static LayoutRegistry registry;
+            return registry;
+        }
+    };
+
+    template<typename O>
+    bool register_layout(const char* type)
+    {
+        LayoutRegistry::instance().reports.push_back(layout_report<O>(type));
+        return true;
+    }
+
+    // -----------------------------------------------
+    // Size budget
+    // -----------------------------------------------
+
+    template<typename Tag, size_t Bytes, size_t Footprint>
+    struct alternative_within_budget
+    {
+        static constexpr bool value = Footprint <= Bytes;
+        static_assert(value, "This alternative alone makes the OneOf exceed its size budget");
+    };
+
+    // Checks the alternatives one by one first, so that the error names the ones that do not fit
+    template<typename O, size_t Bytes, typename Indices> struct within_budget_impl {};
+    template<typename... Tags, size_t Bytes, size_t... Is>
+    struct within_budget_impl<OneOf<Tags...>, Bytes, index_sequence<Is...>> : std::integral_constant<bool,
+        all_of<alternative_within_budget<Tags, Bytes, layout<OneOf<Tags...>>::footprints[Is]>::value...>::value &&
+        sizeof(OneOf<Tags...>) <= Bytes> {};
+
+    template<typename O, size_t Bytes> struct within_budget {};
+    template<typename... Tags, size_t Bytes>
+    struct within_budget<OneOf<Tags...>, Bytes> : within_budget_impl<OneOf<Tags...>, Bytes, index_sequence_for<Tags...>> {};
+}
+
+    /**
+     * @return the layouts of the OneOf types registered with ONE_OF_REPORT_LAYOUT, in the order of their registration
+     */
+    inline const std::vector<LayoutReport>& layout_reports()
+    {
+        return details::LayoutRegistry::instance().reports;
+    }
+}
@@ -0,0 +1,248 @@
+#pragma once
+
+#include "one_of.h"
+
+#include <stdint.h>
+#include <type_traits>
+#include <utility>
+
+namespace one_of
+{
+    /**
+     * Handles one combination of tags in match2 / match3, built by one_of::on
+     * @tparam Callback called with the values of the alternatives, in the order of the matched OneOfs
+     * @tparam Tags one tag per matched OneOf
+     */
+    template<typename Callback, typename... Tags>
+    struct Case
+    {
+        Callback callback;
+    };
+
+    /**
+     * Handles the combinations of tags that have no Case in match2 / match3, built by one_of::otherwise
+     */
+    template<typename Callback>
+    struct Otherwise
+    {
+        Callback callback;
+    };
+
+    /**
+     * @tparam Tags one tag per matched OneOf
+     * @param cb the function that will be called if the OneOfs match the tags
+     */
+    template<typename... Tags, typename Callback>
+    Case<typename std::decay<Callback>::type, Tags...> on(Callback&& cb)
+    {
+        return Case<typename std::decay<Callback>::type, Tags...>{std::forward<Callback>(cb)};
+    }
+
+    /**
+     * @param cb the function, without arguments, that will be called for unhandled combinations of tags
+     */
+    template<typename Callback>
+    Otherwise<typename std::decay<Callback>::type> otherwise(Callback&& cb)
+    {
+        return Otherwise<typename std::decay<Callback>::type>{std::forward<Callback>(cb)};
+    }
+
+namespace details
+{
+    // -----------------------------------------------
+    // Combinations of tags
+    // -----------------------------------------------
+
+    // The combinations are numbered in row-major order : the last OneOf varies fastest
+
+    template<typename Lists> struct combination_count {};
+    template<> struct combination_count<type_list<>> : std::integral_constant<size_t, 1> {};
+    template<typename... Head, typename... Tail> struct combination_count<type_list<type_list<Head...>, Tail...>>
+        : std::integral_constant<size_t, sizeof...(Head) * combination_count<type_list<Tail...>>::value> {};
+
+    template<typename T, typename List> struct prepend {};
+    template<typename T, typename... Ts> struct prepend<T, type_list<Ts...>> { typedef type_list<T, Ts...> type; };
+
+    template<size_t I, typename Lists> struct combination {};
+    template<size_t I> struct combination<I, type_list<>> { typedef type_list<> type; };
+    template<size_t I, typename... Head, typename... Tail> struct combination<I, type_list<type_list<Head...>, Tail...>>
+    {
+        static constexpr size_t stride = combination_count<type_list<Tail...>>::value;
+        typedef typename prepend<
+            type_at<I / stride, Head...>,
+            typename combination<I % stride, type_list<Tail...>>::type
+        >::type type;
+    };
+
+    // -----------------------------------------------
+    // Handlers
+    // -----------------------------------------------
+
+    template<typename H> struct case_key                                { typedef void type; };
+    template<typename Cb, typename... Tags> struct case_key<Case<Cb, Tags...>>   { typedef type_list<Tags...> type; };
+
+    template<typename H> struct is_otherwise : std::false_type {};
+    template<typename Cb> struct is_otherwise<Otherwise<Cb>> : std::true_type {};
+
+    // Index of the Case handling the given combination, or of the Otherwise handler, or the number of handlers
+    template<typename Key, typename... Handlers>
+    struct handler_for
+    {
+        static constexpr bool cases[sizeof...(Handlers)] = { std::is_same<Key, typename case_key<Handlers>::type>::value... };
+        static constexpr bool fallbacks[sizeof...(Handlers)] = { is_otherwise<Handlers>::value... };
+        static constexpr uint32_t case_index = find_first(cases, sizeof...(Handlers), true);
+        static constexpr uint32_t value = case_index < sizeof...(Handlers) ? case_index : find_first(fallbacks, sizeof...(Handlers), true);
+    };
+
+    template<typename Key, typename... Handlers> constexpr bool handler_for<Key, Handlers...>::cases[];
+    template<typename Key, typename... Handlers> constexpr bool handler_for<Key, Handlers...>::fallbacks[];
+
+    template<typename List> struct variant_of {};
+    template<typename... Tags> struct variant_of<type_list<Tags...>> { typedef TaggedUnion<Tags...> type; };
+
+    // Checks that each Case has one tag per OneOf, which is one of its alternatives
+    template<bool SameSize, typename Key, typename Lists>
+    struct valid_key : std::false_type
+    {
+        static_assert(SameSize, "A case must have exactly one tag per matched OneOf");
+    };
+
+    template<typename... Tags, typename... Lists>
+    struct valid_key<true, type_list<Tags...>, type_list<Lists...>> : all_of<
+        (index_of<Tags, typename variant_of<Lists>::type>::value < size_of<typename variant_of<Lists>::type>::value)...
+    > {};
+
+    template<typename Key, typename Lists> struct valid_case : std::true_type {};
+    template<typename... Tags, typename... Lists> struct valid_case<type_list<Tags...>, type_list<Lists...>>
+        : valid_key<sizeof...(Tags) == sizeof...(Lists), type_list<Tags...>, type_list<Lists...>> {};
+
+    template<typename Key, typename... Handlers>
+    struct count_key
+    {
+        static constexpr bool same[sizeof...(Handlers)] = { std::is_same<Key, typename case_key<Handlers>::type>::value... };
+        static constexpr uint32_t value = count(same, sizeof...(Handlers), true);
+    };
+
+    template<typename Key, typename... Handlers> constexpr bool count_key<Key, Handlers...>::same[];
+
+    // -----------------------------------------------
+    // Result type
+    // -----------------------------------------------
+
+    template<typename Handler, typename Operands> struct handler_result {};
+
+    template<typename Cb, typename... Tags, typename... Operands>
+    struct handler_result<Case<Cb, Tags...>, type_list<Operands...>>
+        : std::result_of<Cb&(typename copy_const<Operands, typename Tags::Type>::type&...)> {};
+
+    template<typename Cb, typename Operands>
+    struct handler_result<Otherwise<Cb>, Operands> : std::result_of<Cb&()> {};
+
+    template<typename Operands, typename... Handlers>
+    struct match_result : common_type_of<typename handler_result<typename std::decay<Handlers>::type, Operands>::type...> {};
+
+    // -----------------------------------------------
+    // Jump table dispatch
+    // -----------------------------------------------
+
+    template<typename R, typename Cb, typename... Tags, typename... Operands, size_t... Is>
+    R call_handler(Case<Cb, Tags...>& handler, void* const* payloads, type_list<Operands...>, index_sequence<Is...>)
+    {
+        return handler.callback(get_at<Tags>(static_cast<typename copy_const<Operands, void>::type*>(payloads[Is]))...);
+    }
+
+    template<typename R, typename Cb, typename Operands, typename Indices>
+    R call_handler(Otherwise<Cb>& handler, void* const*, Operands, Indices)
+    {
+        return handler.callback();
+    }
+
+    template<typename R, typename Operands, typename Lists, typename Handlers> struct combination_dispatch {};
+
+    template<typename R, typename... Operands, typename Lists, typename... Handlers>
+    struct combination_dispatch<R, type_list<Operands...>, Lists, type_list<Handlers...>>
+    {
+        template<size_t I, typename HandlerTuple>
+        static R call(void* const* payloads, HandlerTuple& handlers)
+        {
+            typedef typename combination<I, Lists>::type Key;
+            return call_handler<R>(get_ref<handler_for<Key, Handlers...>::value>(handlers), payloads, type_list<Operands...>(), index_sequence_for<Operands...>());
+        }
+
+        /**
+         * Calls the handler of the given combination, through a table with one entry per combination of tags
+         */
+        template<typename HandlerTuple, size_t... Is>
+        static R dispatch(uint32_t combination, void* const* payloads, HandlerTuple& handlers, index_sequence<Is...>)
+        {
+            typedef R (*Entry)(void* const*, HandlerTuple&);
+            static constexpr Entry table[] = { &call<Is, HandlerTuple>... };
+            return table[combination](payloads, handlers);
+        }
+    };
+
+    // Only declared : when the match is invalid, the static assertions are the only errors
+    template<typename R, typename Lists, typename... Handlers, typename HandlerTuple, typename... Operands>
+    R dispatch_operands(std::false_type, type_list<Handlers...>, HandlerTuple& handlers, Operands&... operands);
+
+    template<typename R, typename Lists, typename... Handlers, typename HandlerTuple, typename... Operands>
+    R dispatch_operands(std::true_type, type_list<Handlers...>, HandlerTuple& handlers, Operands&... operands)
+    {
+        const uint32_t indices[] = { operands.index()... };
+        const uint32_t sizes[] = { size_of<typename variant_of<typename tags_of<Operands>::type>::type>::value... };
+        void* const payloads[] = { const_cast<void*>(static_cast<const void*>(OneOfAccess::payload(operands)))... };
+
+        uint32_t combination = 0;
+        for (size_t i = 0; i < sizeof...(Operands); ++i) { combination = combination * sizes[i] + indices[i]; }
+
+        return combination_dispatch<R, type_list<Operands...>, Lists, type_list<typename std::decay<Handlers>::type...>>::dispatch(
+            combination, payloads, handlers, make_index_sequence<combination_count<Lists>::value>());
+    }
+
+    template<typename... Handlers, typename HandlerTuple, typename... Operands>
+    typename match_result<type_list<Operands...>, Handlers...>::type 
+    match_operands(type_list<Handlers...>, HandlerTuple& handlers, Operands&... operands)
+    {
+        typedef typename match_result<type_list<Operands...>, Handlers...>::type Result;
+        typedef type_list<typename tags_of<typename std::remove_const<Operands>::type>::type...> Lists;
+
+        constexpr bool valid = all_of<valid_case<typename case_key<typename std::decay<Handlers>::type>::type, Lists>::value...>::value;
+        static_assert(valid, "A case does not match the OneOfs");
+
+        constexpr bool unique = all_of<(count_key<typename case_key<typename std::decay<Handlers>::type>::type, typename std::decay<Handlers>::type...>::value == 1)...>::value;
+        static_assert(unique, "Can not match the same combination of tags twice, nor have several fallbacks");
+
+        constexpr bool exhaustive = count_key<void, typename std::decay<Handlers>::type...>::value == 1 || sizeof...(Handlers) == combination_count<Lists>::value;
+        static_assert(exhaustive, "Match is not exhaustive : add a case for each combination of tags, or a one_of::otherwise fallback");
+
+        return dispatch_operands<Result, Lists>(std::integral_constant<bool, valid && unique && exhaustive>(), type_list<Handlers...>(), handlers, operands...);
+    }
+}
+
+    /**
+     * Matches a pair of OneOfs through a single table indexed by both tags
+     * @param a the first OneOf
+     * @param b the second OneOf
+     * @param handlers one_of::on<TagA, TagB>(cb) cases, which must cover all the combinations of tags
+     *        unless a one_of::otherwise(cb) fallback is given
+     * @return the value returned by the called handler, converted to the common type of all handlers
+     */
+    template<typename A, typename B, typename... Handlers>
+    typename details::match_result<details::type_list<A, B>, Handlers...>::type 
+    match2(A& a, B& b, Handlers&&... handlers)
+    {
+        details::ref_tuple<Handlers...> handler_refs(handlers...);
+        return details::match_operands(details::type_list<Handlers...>(), handler_refs, a, b);
+    }
+
+    /**
+     * Same as match2, for three OneOfs, with one_of::on<TagA, TagB, TagC>(cb) cases
+     */
+    template<typename A, typename B, typename C, typename... Handlers>
+    typename details::match_result<details::type_list<A, B, C>, Handlers...>::type 
+    match3(A& a, B& b, C& c, Handlers&&... handlers)
+    {
+        details::ref_tuple<Handlers...> handler_refs(handlers...);
+        return details::match_operands(details::type_list<Handlers...>(), handler_refs, a, b, c);
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+namespace one_of
+{
+    /**
+     * Declares the niches of a type : bit patterns that are never taken by a valid instance of the type.
+     * A OneOf made of one alternative with enough niches and of empty alternatives stores its tag 
+     * in these niches instead of in a separate index, so it is as small as the non-empty alternative.
+     * 
+     * Specializations must provide :
+     *  - static constexpr uint32_t count : the number of niches
+     *  - static void set(void* storage, uint32_t niche) : writes the given niche (< count) in the storage of a T
+     *  - static uint32_t get(const void* storage) : returns the niche held by the storage, or count if it holds a valid T
+     * @tparam T the type of the alternative
+     */
+    template<typename T>
+    struct niche_traits
+    {
+        static constexpr uint32_t count = 0;
+    };
+
+    /**
+     * Helper to define niche_traits for types represented by an integer (enums, non-null pointers...)
+     * @tparam Raw the integer type representing the type (its size must be the size of the type)
+     * @tparam First the first raw value that is never taken by a valid instance
+     * @tparam Count the number of consecutive raw values that are never taken by a valid instance
+     */
+    template<typename Raw, Raw First, uint32_t Count>
+    struct sentinel_niches
+    {
+        static constexpr uint32_t count = Count;
+
+        static void set(void* storage, uint32_t niche)
+        {
+            const Raw raw = static_cast<Raw>(First + niche);
+            memcpy(storage, &raw, sizeof(Raw));
+        }
+
+        static uint32_t get(const void* storage)
+        {
+            Raw raw;
+            memcpy(&raw, storage, sizeof(Raw));
+            const uint64_t offset = static_cast<uint64_t>(raw) - static_cast<uint64_t>(First);
+            return offset < Count ? static_cast<uint32_t>(offset) : Count;
+        }
+    };
+}
@@ -1,26 +1,51 @@
 #pragma once
 
+#include "details/compare.h"
+#include "details/convert.h"
+#include "details/meta.h"
+#include "details/storage.h"
 #include "details/tagged_union.h"
+#include "details/visit.h"
+#include "instrumentation.h"
 
-#include <functional>
+#include <type_traits>
+#include <utility>
 
 #define ONE_OF_CREATE_ALTERNATIVE(tag, type) struct tag{ typedef type Type; }; 
 
+// The value of a boxed alternative is allocated out of line, so that it does not inflate the size of the OneOf
+#define ONE_OF_CREATE_BOXED_ALTERNATIVE(tag, type) struct tag{ typedef type Type; typedef ::one_of::FreeListPool BoxAllocator; }; 
+#define ONE_OF_CREATE_BOXED_ALTERNATIVE_IN(tag, type, allocator) struct tag{ typedef type Type; typedef allocator BoxAllocator; }; 
+
 namespace one_of
 {
+namespace details 
+{ 
+    struct OneOfAccess; 
+
+    template<typename... Tags> struct one_of_of<TaggedUnion<Tags...>> { typedef OneOf<Tags...> type; };
+}
+
     /**
      * Allows to visit a const OneOf instance
      * @tparam V the variant type of the OneOf instance
-     * @tparam Flags a bitmap describing which tag have already been matched
-     *               (0b100 means that the 3rd tag has already been matched)
+     * @tparam Matched the set of the indices of the tags that have already been matched
      */
-    template<typename V, uint64_t Flags = 0>
+    template<typename V, typename Matched = details::index_set<>>
     class ConstVisitor
     {
     public:
 
         explicit ConstVisitor(const V& val, const uint32_t& index, const bool& already_found = false) : 
-            _val(val), 
+            _val(&val), 
+            _index(index),
+            _already_found(already_found) {}
+
+        /**
+         * @param payload the address of the active payload, which may not be stored in a V
+         */
+        ConstVisitor(const void* payload, const uint32_t& index, const bool& already_found = false) : 
+            _val(payload), 
             _index(index),
             _already_found(already_found) {}
 
@@ -30,24 +55,27 @@ namespace one_of
          * @param cb the function that will be called if the OneOf matches the tag
          * @return A visitor for chained calls
          */
-        template<typename Tag>
-        ConstVisitor<V, Flags | (1 << details::index_of<Tag, V>::value)> match(std::function<void(const typename Tag::Type&)> cb)
+        template<typename Tag, typename Callback>
+        ConstVisitor<V, typename Matched::template insert<details::index_of<Tag, V>::value>> match(Callback&& cb)
         {
-            static_assert((Flags & (1 << details::index_of<Tag, V>::value)) == 0, "Can not match the same tag twice");
+            static_assert(!Matched::template contains<details::index_of<Tag, V>::value>::value, "Can not match the same tag twice");
 
-            if (details::index_of<Tag, V>::value == _index)
+            const bool matches = details::index_of<Tag, V>::value == _index;
+            if (is_hot<Tag>::value ? ONE_OF_LIKELY(matches) : matches)
             {
                 _already_found = true;
-                cb(details::get<Tag>(_val));
+                details::MatchScope<typename details::one_of_of<V>::type> scope(_index);
+                cb(details::get_at<Tag>(_val));
             }
-            return ConstVisitor<V, Flags | (1 << details::index_of<Tag, V>::value)>(_val, _index, _already_found);
+            return ConstVisitor<V, typename Matched::template insert<details::index_of<Tag, V>::value>>(_val, _index, _already_found);
         }
 
         /**
          * Defines a fallback function that handles unmatched tags
          * @param cb in case of an unmatched tag, this function will be called
          */
-        void fallback(std::function<void()> cb)
+        template<typename Callback>
+        void fallback(Callback&& cb)
         {
             if (!_already_found) { cb(); }
         }
@@ -57,12 +85,12 @@ namespace one_of
          */
         void assertMatchIsExhaustive() const
         {
-            static_assert(Flags == (1 << details::size_of<V>::value) - 1, "Match is not exhaustive");
+            static_assert(Matched::size == details::size_of<V>::value, "Match is not exhaustive");
         }
 
     private:
 
-        const V& _val;
+        const void* _val;
         const uint32_t _index;
         bool _already_found;
     };
@@ -70,16 +98,23 @@ namespace one_of
     /**
      * Allows to visit a non-const OneOf instance
      * @tparam V the variant type of the OneOf instance
-     * @tparam Flags a bitmap describing which tags have already been matched
-     *               (0b100 means that the 3rd tag has already been matched)
+     * @tparam Matched the set of the indices of the tags that have already been matched
      */
-    template<typename V, uint64_t Flags = 0>
+    template<typename V, typename Matched = details::index_set<>>
     class MutVisitor
     {
     public:
 
         explicit MutVisitor(V& val, const uint32_t& index, bool already_found = false) : 
-            _val(val), 
+            _val(&val), 
+            _index(index), 
+            _already_found(already_found) {}
+
+        /**
+         * @param payload the address of the active payload, which may not be stored in a V
+         */
+        MutVisitor(void* payload, const uint32_t& index, bool already_found = false) : 
+            _val(payload), 
             _index(index), 
             _already_found(already_found) {}
 
@@ -89,24 +124,27 @@ namespace one_of
          * @param cb the function that will be called if the OneOf matches the tag
          * @return A visitor for chained calls
          */
-        template<typename Tag>
-        MutVisitor<V, Flags | (1 << details::index_of<Tag, V>::value)> match(std::function<void(typename Tag::Type&)> cb)
+        template<typename Tag, typename Callback>
+        MutVisitor<V, typename Matched::template insert<details::index_of<Tag, V>::value>> match(Callback&& cb)
         {
-            static_assert((Flags & (1 << details::index_of<Tag, V>::value)) == 0, "Can not match the same tag twice");
+            static_assert(!Matched::template contains<details::index_of<Tag, V>::value>::value, "Can not match the same tag twice");
 
-            if (details::index_of<Tag, V>::value == _index)
+            const bool matches = details::index_of<Tag, V>::value == _index;
+            if (is_hot<Tag>::value ? ONE_OF_LIKELY(matches) : matches)
             {
                 _already_found = true;
-                cb(details::get<Tag>(_val));
+                details::MatchScope<typename details::one_of_of<V>::type> scope(_index);
+                cb(details::get_at<Tag>(_val));
             }
-            return MutVisitor<V, Flags | (1 << details::index_of<Tag, V>::value)>(_val, _index, _already_found);
+            return MutVisitor<V, typename Matched::template insert<details::index_of<Tag, V>::value>>(_val, _index, _already_found);
         }
 
         /**
          * Defines a fallback function that handles unmatched Tags
          * @param cb in case of an unmatched tag, this function will be called with the tag's index
          */
-        void fallback(std::function<void()> cb)
+        template<typename Callback>
+        void fallback(Callback&& cb)
         {
             if (!_already_found) { cb(); }
         }
@@ -116,12 +154,12 @@ namespace one_of
          */
         void assertMatchIsExhaustive() const
         {
-            static_assert(Flags == (1 << details::size_of<V>::value) - 1, "Match is not exhaustive");
+            static_assert(Matched::size == details::size_of<V>::value, "Match is not exhaustive");
         }
 
     private:
 
-        V& _val;
+        void* _val;
         const uint32_t _index;
         bool _already_found;
     };
@@ -131,62 +169,85 @@ namespace one_of
      * @tparam Tags : the tags of this oneof
      */
     template<typename... Tags>
-    class OneOf
+    class OneOf : private details::CopyableStorage<
+        details::all_of<std::is_trivially_copyable<details::stored_type<Tags>>::value...>::value && !instrumentation<OneOf<Tags...>>::enabled, 
+        Tags...>
     {
     public:
 
+        // The constructors are constant expressions when the alternatives are literal types, 
+        // the OneOf is not instrumented and its index is not stored in niches
+
         template<typename Tag>
-        OneOf(Tag)
-        {
-            _index = details::index_of<Tag, Variant>::value;
-            details::construct<Tag>(_value);
-        }
+        constexpr OneOf(Tag) : 
+            Storage(details::notify_constructed<Instrumentation>(details::in_place_index<details::index_of<Tag, Variant>::value>())) {}
 
         template<typename Tag, typename... Args>
-        OneOf(Tag, Args&&... args)
-        {
-            _index = details::index_of<Tag, Variant>::value;
-            details::construct<Tag>(_value, args...);
-        }
+        constexpr OneOf(Tag, Args&&... args) : 
+            Storage(details::notify_constructed<Instrumentation>(details::in_place_index<details::index_of<Tag, Variant>::value>()), std::forward<Args>(args)...) {}
 
-        OneOf(const OneOf& other)
-        {
-            _index = other._index;
-            copy<Tags...>(other._value, other._index);
-        }
+        /**
+         * Widens a OneOf whose tags are all tags of this OneOf : the payload is copied, or moved, 
+         * into the alternative of the same tag, whatever its position
+         * @param other the OneOf to widen
+         */
+        template<typename... Others, typename = typename std::enable_if<details::is_widening<OneOf<Others...>, OneOf>::value>::type>
+        OneOf(const OneOf<Others...>& other) : 
+            OneOf(details::Converting<const void>{ details::copy_conversions<OneOf<Others...>, OneOf>::entries[other.index()], &other._value }) {}
 
-        void operator=(const OneOf& other)
-        {
-            destruct<Tags...>(_index);
-            _index = other._index;
-            copy<Tags...>(other._value, other._index);
-        }
+        template<typename... Others, typename = typename std::enable_if<details::is_widening<OneOf<Others...>, OneOf>::value>::type>
+        OneOf(OneOf<Others...>&& other) : 
+            OneOf(details::Converting<void>{ details::move_conversions<OneOf<Others...>, OneOf>::entries[other.index()], &other._value }) {}
 
-        ~OneOf()
+        /**
+         * Constructs the alternative of another OneOf from its payload, see try_narrow
+         * @param converting the payload of the other OneOf and the conversion of its active alternative, which must be one of the tags
+         */
+        template<typename Payload>
+        explicit OneOf(const details::Converting<Payload>& converting) : 
+            Storage(details::convert_from(), converting.conversion.construct, converting.payload, converting.conversion.to)
         {
-            destruct<Tags...>(_index);
+            Instrumentation::constructed(converting.conversion.to);
         }
 
+        OneOf(const OneOf&) = default;
+        OneOf(OneOf&&) = default;
+        OneOf& operator=(const OneOf&) = default;
+        OneOf& operator=(OneOf&&) = default;
+        ~OneOf() = default;
+
+        /**
+         * Replaces the active alternative by the alternative of the given tag, constructed from the arguments.
+         * If that construction throws, the OneOf keeps its alternative when the new payload can be moved without throwing, 
+         * and holds its first nothrow default constructible alternative otherwise (and the same goes for assignments)
+         */
         template<typename Tag, typename... Args>
         void emplace(Args&&... args)
         {
-            destruct<Tags...>(_index);
-            _index = details::index_of<Tag, Variant>::value;
-            details::construct<Tag>(_value, args...);
+            Storage::template emplaceAlternative<details::index_of<Tag, Variant>::value>(std::forward<Args>(args)...);
+            Instrumentation::emplaced(details::index_of<Tag, Variant>::value);
         }
 
         typedef details::TaggedUnion<Tags...> Variant;
 
+        /**
+         * @return the index of the active tag, in the order of the tags
+         */
+        constexpr uint32_t index() const
+        {
+            return Storage::index();
+        }
+
         /**
          * Matches a const OneOf with the given tag
          * @tparam Tag the tag to match
          * @param cb the function that will be called if the OneOf matches the tag
          * @return A visitor for chained calls
          */
-        template<typename Tag>
-        ConstVisitor<Variant, (1 << details::index_of<Tag, Variant>::value)> match(std::function<void(const typename Tag::Type&)> cb) const
+        template<typename Tag, typename Callback>
+        ConstVisitor<Variant, details::index_set<details::index_of<Tag, Variant>::value>> match(Callback&& cb) const
         {
-            return ConstVisitor<Variant>(_value, _index).template match<Tag>(cb);
+            return ConstVisitor<Variant>(_value, index()).template match<Tag>(std::forward<Callback>(cb));
         }
 
         /**
@@ -195,61 +256,216 @@ namespace one_of
          * @param cb the function that will be called if the OneOf matches the tag
          * @return A visitor for chained calls
          */
+        template<typename Tag, typename Callback>
+        MutVisitor<Variant, details::index_set<details::index_of<Tag, Variant>::value>> match(Callback&& cb)
+        {
+            return MutVisitor<Variant>(_value, index()).template match<Tag>(std::forward<Callback>(cb));
+        }
+
+        /**
+         * Visits a const OneOf with one handler per tag, in the order of the tags
+         * @param handlers the functions to call, the one matching the current tag will be called
+         * @return the value returned by the called handler, converted to the common type of all handlers
+         */
+        template<typename... Handlers>
+        ONE_OF_CONSTEXPR14 typename details::visit_result<details::type_list<const typename Tags::Type&...>, details::type_list<Handlers...>>::type 
+        visit(Handlers&&... handlers) const
+        {
+            typedef typename details::visit_result<details::type_list<const typename Tags::Type&...>, details::type_list<Handlers...>>::type Result;
+            details::ref_tuple<Handlers...> handler_refs(handlers...);
+            details::MatchScope<OneOf> scope(index());
+            return details::visit<Result>(&_value, index(), details::type_list<Tags...>(), details::index_sequence_for<Tags...>(), handler_refs);
+        }
+
+        /**
+         * Visits a non-const OneOf with one handler per tag, in the order of the tags
+         * @param handlers the functions to call, the one matching the current tag will be called
+         * @return the value returned by the called handler, converted to the common type of all handlers
+         */
+        template<typename... Handlers>
+        ONE_OF_CONSTEXPR14 typename details::visit_result<details::type_list<typename Tags::Type&...>, details::type_list<Handlers...>>::type 
+        visit(Handlers&&... handlers)
+        {
+            typedef typename details::visit_result<details::type_list<typename Tags::Type&...>, details::type_list<Handlers...>>::type Result;
+            details::ref_tuple<Handlers...> handler_refs(handlers...);
+            details::MatchScope<OneOf> scope(index());
+            return details::visit<Result>(&_value, index(), details::type_list<Tags...>(), details::index_sequence_for<Tags...>(), handler_refs);
+        }
+
+        /**
+         * Narrows a const OneOf to a OneOf type holding a subset of its tags
+         * @tparam Target the OneOf type to narrow to
+         * @return Narrowed<Target> holding a copy of the payload, or NotNarrowed if the active tag is not a tag of Target
+         */
+        template<typename Target>
+        NarrowResult<Target> try_narrow() const &
+        {
+            const details::Conversion<const void>& conversion = details::copy_conversions<OneOf, Target>::entries[index()];
+            if (conversion.to == details::size_of<typename Target::Variant>::value) { return NarrowResult<Target>(NotNarrowed()); }
+            return NarrowResult<Target>(Narrowed<Target>(), details::Converting<const void>{ conversion, &_value });
+        }
+
+        /**
+         * Narrows a OneOf to a OneOf type holding a subset of its tags, moving the payload when it succeeds
+         * @tparam Target the OneOf type to narrow to
+         * @return Narrowed<Target> holding the payload, or NotNarrowed if the active tag is not a tag of Target
+         */
+        template<typename Target>
+        NarrowResult<Target> try_narrow() &&
+        {
+            const details::Conversion<void>& conversion = details::move_conversions<OneOf, Target>::entries[index()];
+            if (conversion.to == details::size_of<typename Target::Variant>::value) { return NarrowResult<Target>(NotNarrowed()); }
+            return NarrowResult<Target>(Narrowed<Target>(), details::Converting<void>{ conversion, &_value });
+        }
+
+        // -----------------------------------------------
+        // Combinators : the results are returned as prvalues, which are constructed in place of the 
+        // returned value (always from C++17), and the rvalue overloads move the payload out
+        // -----------------------------------------------
+
+        /**
+         * @tparam Tag the tag whose payload is requested
+         * @return the address of the payload if Tag is the active tag, null otherwise
+         */
         template<typename Tag>
-        MutVisitor<Variant, (1 << details::index_of<Tag, Variant>::value)> match(std::function<void(typename Tag::Type&)> cb)
+        const typename Tag::Type* get_if() const &
         {
-            return MutVisitor<Variant>(_value, _index).template match<Tag>(cb);
+            return index() == details::index_of<Tag, Variant>::value ? &details::get_at<Tag>(&_value) : nullptr;
         }
 
-    private:
+        template<typename Tag>
+        typename Tag::Type* get_if() &
+        {
+            return index() == details::index_of<Tag, Variant>::value ? &details::get_at<Tag>(&_value) : nullptr;
+        }
 
-        template<typename T>
-        void destruct(const uint32_t& index) 
+        // The payload of a temporary does not outlive the expression
+        template<typename Tag> void get_if() && = delete;
+
+        /**
+         * @tparam Tag the tag whose payload is requested
+         * @param fallback the value to return if Tag is not the active tag
+         * @return a copy of the payload if Tag is the active tag, the fallback otherwise
+         */
+        template<typename Tag, typename U>
+        typename Tag::Type value_or(U&& fallback) const &
         {
-            details::destruct<T>(_value);
+            if (index() == details::index_of<Tag, Variant>::value) { return details::get_at<Tag>(&_value); }
+            return static_cast<typename Tag::Type>(std::forward<U>(fallback));
         }
 
-        template<typename T1, typename T2, typename... Ts> 
-        void destruct(const uint32_t& index) 
+        template<typename Tag, typename U>
+        typename Tag::Type value_or(U&& fallback) &&
         {
-            if(index == 0) 
-            {
-                details::destruct<T1>(_value);
-            }
-            else if(index == 1) 
-            {
-                details::destruct<T2>(_value);
-            }
-            else 
-            {
-                destruct<T2, Ts...>(index - 1);
-            }
+            if (index() == details::index_of<Tag, Variant>::value) { return std::move(details::get_at<Tag>(&_value)); }
+            return static_cast<typename Tag::Type>(std::forward<U>(fallback));
         }
 
-        template<typename T>
-        void copy(const Variant& other, const uint32_t& index) 
-        { 
-            details::construct<T>(_value, details::get<T>(other));
+        /**
+         * Transforms the payload of the given tag, keeping the other alternatives as they are
+         * @tparam Tag the tag whose payload is transformed
+         * @param f the function called with the payload, returning the new payload of the same tag
+         * @return a OneOf holding the transformed payload if Tag is the active tag, a copy of this OneOf otherwise
+         */
+        template<typename Tag, typename F>
+        OneOf map(F&& f) const &
+        {
+            if (index() == details::index_of<Tag, Variant>::value) { return OneOf(Tag(), f(details::get_at<Tag>(&_value))); }
+            return *this;
         }
 
-        template<typename T1, typename T2, typename... Ts> 
-        void copy(const Variant& other, const uint32_t& index) 
+        template<typename Tag, typename F>
+        OneOf map(F&& f) &&
         {
-            if(index == 0) 
-            {
-                details::construct<T1>(_value, details::get<T1>(other));
-            }
-            else if(index == 1) 
-            {
-                details::construct<T2>(_value, details::get<T2>(other));
-            }
-            else 
-            {
-                copy<T2, Ts...>(other, index - 1);
-            }
+            if (index() == details::index_of<Tag, Variant>::value) { return OneOf(Tag(), f(std::move(details::get_at<Tag>(&_value)))); }
+            return std::move(*this);
+        }
+
+        /**
+         * Chains a computation returning a OneOf on the payload of the given tag
+         * @tparam Tag the tag whose payload is passed to the function
+         * @param f the function called with the payload, returning a OneOf which holds all the other tags of this OneOf
+         * @return the OneOf returned by f if Tag is the active tag, the active alternative converted to its type otherwise
+         */
+        template<typename Tag, typename F>
+        typename std::result_of<F&(const typename Tag::Type&)>::type and_then(F&& f) const &
+        {
+            typedef typename std::result_of<F&(const typename Tag::Type&)>::type Result;
+            static_assert(details::keeps_other_tags<Tag, OneOf, Result>::value, "and_then expects a OneOf holding the other tags");
+
+            if (index() == details::index_of<Tag, Variant>::value) { return f(details::get_at<Tag>(&_value)); }
+            return Result(details::Converting<const void>{ details::copy_conversions<OneOf, Result>::entries[index()], &_value });
         }
 
-        Variant _value;
-        uint32_t _index = 0;
+        template<typename Tag, typename F>
+        typename std::result_of<F&(typename Tag::Type&&)>::type and_then(F&& f) &&
+        {
+            typedef typename std::result_of<F&(typename Tag::Type&&)>::type Result;
+            static_assert(details::keeps_other_tags<Tag, OneOf, Result>::value, "and_then expects a OneOf holding the other tags");
+
+            if (index() == details::index_of<Tag, Variant>::value) { return f(std::move(details::get_at<Tag>(&_value))); }
+            return Result(details::Converting<void>{ details::move_conversions<OneOf, Result>::entries[index()], &_value });
+        }
+
+    private:
+
+        template<typename...> friend class OneOf;
+        friend struct details::OneOfAccess;
+
+        typedef details::CopyableStorage<
+            details::all_of<std::is_trivially_copyable<details::stored_type<Tags>>::value...>::value && !instrumentation<OneOf>::enabled, 
+            Tags...
+        > Storage;
+
+        typedef instrumentation<OneOf> Instrumentation;
+
+        using Storage::_value;
+        using Storage::setIndex;
+        using Storage::destructActive;
+        using Storage::indexOffset;
+        using Storage::payloadOffset;
     };
+
+namespace details
+{
+    // Gives the free functions of the library access to the payload of a OneOf
+    struct OneOfAccess
+    {
+        template<typename... Tags> static void* payload(OneOf<Tags...>& value)              { return &value._value; }
+        template<typename... Tags> static const void* payload(const OneOf<Tags...>& value)  { return &value._value; }
+
+        template<typename... Tags> 
+        static constexpr const TaggedUnion<Tags...>& variant(const OneOf<Tags...>& value)   { return value._value; }
+
+        template<typename... Tags> static size_t index_offset()                              { return OneOf<Tags...>::indexOffset(); }
+        template<typename... Tags> static size_t payload_offset()                            { return OneOf<Tags...>::payloadOffset(); }
+    };
+
+    template<typename O> struct tags_of {};
+    template<typename... Tags> struct tags_of<OneOf<Tags...>>           { typedef type_list<Tags...> type; };
+    template<typename... Tags> struct tags_of<const OneOf<Tags...>>     { typedef type_list<Tags...> type; };
+}
+
+    // -----------------------------------------------
+    // Comparisons : the indices first, then the payloads of the same alternative
+    // -----------------------------------------------
+
+    template<typename... Tags>
+    constexpr bool operator==(const OneOf<Tags...>& a, const OneOf<Tags...>& b)
+    {
+        return a.index() == b.index() && details::equal_payloads(
+            details::OneOfAccess::variant(a), details::OneOfAccess::variant(b), a.index(), details::all_trivially_comparable<Tags...>());
+    }
+
+    template<typename... Tags>
+    constexpr bool operator<(const OneOf<Tags...>& a, const OneOf<Tags...>& b)
+    {
+        return a.index() != b.index() ? a.index() < b.index() : 
+               details::less_payloads(details::OneOfAccess::variant(a), details::OneOfAccess::variant(b), a.index());
+    }
+
+    template<typename... Tags> constexpr bool operator!=(const OneOf<Tags...>& a, const OneOf<Tags...>& b)    { return !(a == b); }
+    template<typename... Tags> constexpr bool operator>(const OneOf<Tags...>& a, const OneOf<Tags...>& b)     { return b < a; }
+    template<typename... Tags> constexpr bool operator<=(const OneOf<Tags...>& a, const OneOf<Tags...>& b)    { return !(b < a); }
+    template<typename... Tags> constexpr bool operator>=(const OneOf<Tags...>& a, const OneOf<Tags...>& b)    { return !(a < b); }
 }
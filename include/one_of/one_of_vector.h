@@ -0,0 +1,282 @@
+#pragma once
+
+#include "one_of.h"
+
+#include <stddef.h>
+#include <iterator>
+#include <vector>
+
+namespace one_of
+{
+    /**
+     * A reference to an element of a OneOfVector, that can be matched like a OneOf
+     * @tparam V the variant type of the OneOf (const qualified for a const reference)
+     * @tparam Tags the tags of the OneOf
+     */
+    template<typename V, typename... Tags>
+    class OneOfReference
+    {
+        template<typename Matched> 
+        using Visitor = typename std::conditional<std::is_const<V>::value, 
+            ConstVisitor<typename std::remove_const<V>::type, Matched>, 
+            MutVisitor<V, Matched>>::type;
+
+        typedef typename details::copy_const<V, void>::type Payload;
+
+    public:
+
+        /**
+         * @param payload the address of the payload of the referenced element
+         * @param index the index of the tag of the referenced element
+         */
+        OneOfReference(Payload* payload, uint32_t index) : _payload(payload), _index(index) {}
+
+        /**
+         * @return the index of the tag of the referenced element
+         */
+        uint32_t index() const { return _index; }
+
+        /**
+         * Matches the referenced element with the given tag
+         * @tparam Tag the tag to match
+         * @param cb the function that will be called if the element matches the tag
+         * @return A visitor for chained calls
+         */
+        template<typename Tag, typename Callback>
+        Visitor<details::index_set<details::index_of<Tag, typename std::remove_const<V>::type>::value>> match(Callback&& cb) const
+        {
+            return Visitor<details::index_set<>>(_payload, _index).template match<Tag>(std::forward<Callback>(cb));
+        }
+
+        /**
+         * Visits the referenced element with one handler per tag, in the order of the tags
+         * @param handlers the functions to call, the one matching the tag of the element will be called
+         * @return the value returned by the called handler, converted to the common type of all handlers
+         */
+        template<typename... Handlers>
+        typename details::visit_result<details::type_list<typename details::copy_const<V, typename Tags::Type>::type&...>, details::type_list<Handlers...>>::type 
+        visit(Handlers&&... handlers) const
+        {
+            typedef typename details::visit_result<details::type_list<typename details::copy_const<V, typename Tags::Type>::type&...>, details::type_list<Handlers...>>::type Result;
+            details::ref_tuple<Handlers...> handler_refs(handlers...);
+            return details::visit<Result>(_payload, _index, details::type_list<Tags...>(), details::index_sequence_for<Tags...>(), handler_refs);
+        }
+
+    private:
+
+        Payload* _payload;
+        uint32_t _index;
+    };
+
+    /**
+     * A sequence of OneOfs stored as one contiguous array per tag, plus the sequence of the tags of the elements.
+     * Each element only takes the size of its own alternative (and of its tag), 
+     * and the elements of a given tag can be processed in a branch-free loop.
+     * @tparam Tags : the tags of the stored OneOfs
+     */
+    template<typename... Tags>
+    class OneOfVector
+    {
+    public:
+
+        typedef OneOf<Tags...> value_type;
+        typedef typename value_type::Variant Variant;
+        typedef OneOfReference<Variant, Tags...> reference;
+        typedef OneOfReference<const Variant, Tags...> const_reference;
+
+        /**
+         * Iterates over the elements in the order they were inserted
+         * @tparam V the variant type of the OneOf (const qualified for a const iterator)
+         */
+        template<typename V>
+        class Iterator
+        {
+            typedef typename details::copy_const<V, char>::type Byte;
+
+        public:
+
+            typedef std::forward_iterator_tag iterator_category;
+            typedef OneOfReference<V, Tags...> value_type;
+            typedef OneOfReference<V, Tags...> reference;
+            typedef ptrdiff_t difference_type;
+            typedef void pointer;
+
+            Iterator(const uint8_t* tags, Byte* const* arrays) : _tags(tags)
+            {
+                for (size_t i = 0; i < sizeof...(Tags); ++i) { _next[i] = arrays[i]; }
+            }
+
+            explicit Iterator(const uint8_t* end) : _tags(end), _next() {}
+
+            reference operator*() const
+            {
+                return reference(_next[*_tags], *_tags);
+            }
+
+            Iterator& operator++()
+            {
+                static constexpr size_t sizes[] = { sizeof(details::stored_type<Tags>)... };
+                _next[*_tags] += sizes[*_tags];
+                ++_tags;
+                return *this;
+            }
+
+            Iterator operator++(int)
+            {
+                Iterator previous = *this;
+                ++(*this);
+                return previous;
+            }
+
+            bool operator==(const Iterator& other) const { return _tags == other._tags; }
+            bool operator!=(const Iterator& other) const { return _tags != other._tags; }
+
+        private:
+
+            const uint8_t* _tags;
+            Byte* _next[sizeof...(Tags)];
+        };
+
+        typedef Iterator<Variant> iterator;
+        typedef Iterator<const Variant> const_iterator;
+
+        /**
+         * Appends a copy of the given OneOf
+         */
+        void push_back(const value_type& value)
+        {
+            typedef void (*Pusher)(OneOfVector&, const value_type&);
+            static constexpr Pusher pushers[] = { &OneOfVector::pushCopy<Tags>... };
+            pushers[value.index()](*this, value);
+        }
+
+        /**
+         * Appends the given OneOf, moving its payload
+         */
+        void push_back(value_type&& value)
+        {
+            typedef void (*Pusher)(OneOfVector&, value_type&);
+            static constexpr Pusher pushers[] = { &OneOfVector::pushMove<Tags>... };
+            pushers[value.index()](*this, value);
+        }
+
+        /**
+         * Constructs an element with the given tag at the end of the sequence.
+         * If an exception is thrown, the sequence is left unchanged
+         * @tparam Tag the tag of the element
+         * @param args the arguments forwarded to the constructor of Tag::Type
+         * @return the constructed payload
+         */
+        template<typename Tag, typename... Args>
+        typename Tag::Type& emplace(Args&&... args)
+        {
+            std::vector<details::stored_type<Tag>>& elements = array<Tag>();
+            elements.emplace_back(std::forward<Args>(args)...);
+            try
+            {
+                _tags.push_back(static_cast<uint8_t>(details::index_of<Tag, Variant>::value));
+            }
+            catch (...)
+            {
+                // Keeps the payload arrays in sync with the tags
+                elements.pop_back();
+                throw;
+            }
+            return details::get_at<Tag>(&elements.back());
+        }
+
+        /**
+         * Calls the given function on all the elements of the given tag, in the order they were inserted
+         * @tparam Tag the tag of the visited elements
+         * @param cb the function to call with each payload
+         */
+        template<typename Tag, typename Callback>
+        void for_each(Callback&& cb)
+        {
+            for (details::stored_type<Tag>& element : array<Tag>()) { cb(details::get_at<Tag>(&element)); }
+        }
+
+        template<typename Tag, typename Callback>
+        void for_each(Callback&& cb) const
+        {
+            for (const details::stored_type<Tag>& element : elements<Tag>()) { cb(details::get_at<Tag>(&element)); }
+        }
+
+        /**
+         * @return the contiguous array holding the payloads of the elements of the given tag 
+         *         (the boxes holding them for a boxed alternative)
+         */
+        template<typename Tag>
+        const std::vector<details::stored_type<Tag>>& elements() const
+        {
+            return details::get_value<details::index_of<Tag, Variant>::value>(_arrays);
+        }
+
+        /**
+         * @return the number of elements of the given tag
+         */
+        template<typename Tag>
+        size_t count() const
+        {
+            return elements<Tag>().size();
+        }
+
+        size_t size() const   { return _tags.size(); }
+        bool empty() const    { return _tags.empty(); }
+
+        void clear()
+        {
+            clearArrays(details::index_sequence_for<Tags...>());
+            _tags.clear();
+        }
+
+        iterator begin()                  { return iterator(_tags.data(), arrayPointers<char>(details::index_sequence_for<Tags...>()).pointers); }
+        iterator end()                    { return iterator(_tags.data() + _tags.size()); }
+        const_iterator begin() const      { return const_iterator(_tags.data(), arrayPointers<const char>(details::index_sequence_for<Tags...>()).pointers); }
+        const_iterator end() const        { return const_iterator(_tags.data() + _tags.size()); }
+
+    private:
+
+        static_assert(sizeof...(Tags) <= 256, "OneOfVector stores its tags on a single byte");
+
+        template<typename Byte>
+        struct ArrayPointers { Byte* pointers[sizeof...(Tags)]; };
+
+        template<typename Tag>
+        std::vector<details::stored_type<Tag>>& array()
+        {
+            return details::get_value<details::index_of<Tag, Variant>::value>(_arrays);
+        }
+
+        template<typename Tag>
+        static void pushCopy(OneOfVector& self, const value_type& value)
+        {
+            value.template match<Tag>([&](const typename Tag::Type& payload) { self.template emplace<Tag>(payload); });
+        }
+
+        template<typename Tag>
+        static void pushMove(OneOfVector& self, value_type& value)
+        {
+            value.template match<Tag>([&](typename Tag::Type& payload) { self.template emplace<Tag>(std::move(payload)); });
+        }
+
+        template<typename Byte, size_t... Is>
+        ArrayPointers<Byte> arrayPointers(details::index_sequence<Is...>) const
+        {
+            ArrayPointers<Byte> result = {{ 
+                reinterpret_cast<Byte*>(const_cast<details::stored_type<Tags>*>(details::get_value<Is>(_arrays).data()))... 
+            }};
+            return result;
+        }
+
+        template<size_t... Is>
+        void clearArrays(details::index_sequence<Is...>)
+        {
+            int expand[] = { (details::get_value<Is>(_arrays).clear(), 0)... };
+            (void)expand;
+        }
+
+        details::value_tuple<std::vector<details::stored_type<Tags>>...> _arrays;
+        std::vector<uint8_t> _tags;
+    };
+}
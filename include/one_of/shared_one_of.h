@@ -0,0 +1,174 @@
+#pragma once
+
+#include "one_of.h"
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+namespace one_of
+{
+    /**
+     * A OneOf whose copies share a single reference counted payload. match and visit only read the payload, 
+     * which is cloned when a shared SharedOneOf is mutated (copy on write), so broadcasting a large payload costs 
+     * one atomic increment per copy.
+     *
+     * Like std::shared_ptr, distinct SharedOneOfs sharing a payload can be used by different threads at once,
+     * but a single SharedOneOf must not be modified by a thread while others use it.
+     * A moved-from SharedOneOf can only be assigned or destroyed.
+     * @tparam Tags : the tags of the OneOf
+     */
+    template<typename... Tags>
+    class SharedOneOf
+    {
+    public:
+
+        typedef OneOf<Tags...> value_type;
+        typedef details::TaggedUnion<Tags...> Variant;
+
+        template<typename Tag, typename... Args>
+        explicit SharedOneOf(Tag tag, Args&&... args) : _block(new Block(value_type(tag, std::forward<Args>(args)...))) {}
+
+        /**
+         * Takes the payload of a OneOf, which is moved rather than copied
+         */
+        explicit SharedOneOf(value_type value) : _block(new Block(std::move(value))) {}
+
+        SharedOneOf(const SharedOneOf& other) : _block(other._block)
+        {
+            _block->references.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        SharedOneOf(SharedOneOf&& other) noexcept : _block(other._block)
+        {
+            other._block = nullptr;
+        }
+
+        SharedOneOf& operator=(const SharedOneOf& other)
+        {
+            Block* block = other._block;
+            block->references.fetch_add(1, std::memory_order_relaxed);
+            release();
+            _block = block;
+            return *this;
+        }
+
+        SharedOneOf& operator=(SharedOneOf&& other) noexcept
+        {
+            if (this == &other) { return *this; }
+            release();
+            _block = other._block;
+            other._block = nullptr;
+            return *this;
+        }
+
+        ~SharedOneOf()
+        {
+            release();
+        }
+
+        /**
+         * @return the index of the active tag, in the order of the tags
+         */
+        uint32_t index() const
+        {
+            return _block->value.index();
+        }
+
+        /**
+         * @return the number of SharedOneOfs sharing the payload
+         */
+        size_t use_count() const
+        {
+            return _block->references.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return the shared OneOf, which is never copied
+         */
+        const value_type& get() const
+        {
+            return _block->value;
+        }
+
+        /**
+         * @return a copy of the shared OneOf
+         */
+        value_type toOneOf() const &
+        {
+            return _block->value;
+        }
+
+        /**
+         * @return the shared OneOf, moved out if this SharedOneOf is its only owner, and copied otherwise
+         */
+        value_type toOneOf() &&
+        {
+            makeUnique();
+            value_type value(std::move(_block->value));
+            release();
+            return value;
+        }
+
+        /**
+         * Matches the shared payload with the given tag, without copying it
+         * @tparam Tag the tag to match
+         * @param cb the function that will be called if the OneOf matches the tag
+         * @return A visitor for chained calls
+         */
+        template<typename Tag, typename Callback>
+        ConstVisitor<Variant, details::index_set<details::index_of<Tag, Variant>::value>> match(Callback&& cb) const
+        {
+            return get().template match<Tag>(std::forward<Callback>(cb));
+        }
+
+        /**
+         * Visits the shared payload with one handler per tag, without copying it
+         */
+        template<typename... Handlers>
+        typename details::visit_result<details::type_list<const typename Tags::Type&...>, details::type_list<Handlers...>>::type
+        visit(Handlers&&... handlers) const
+        {
+            return get().visit(std::forward<Handlers>(handlers)...);
+        }
+
+        /**
+         * @return the OneOf owned by this SharedOneOf only, after cloning the payload if it is shared, 
+         * so that the changes made through it are not seen by the other copies
+         */
+        value_type& mutate()
+        {
+            makeUnique();
+            return _block->value;
+        }
+
+    private:
+
+        struct Block
+        {
+            explicit Block(value_type&& payload) : references(1), value(std::move(payload)) {}
+
+            std::atomic<size_t> references;
+            value_type value;
+        };
+
+        // The acquire load sees the writes made by the previous owners before they released the payload
+        void makeUnique()
+        {
+            if (_block->references.load(std::memory_order_acquire) == 1) { return; }
+
+            Block* clone = new Block(value_type(_block->value));
+            release();
+            _block = clone;
+        }
+
+        void release()
+        {
+            if (_block != nullptr && _block->references.fetch_sub(1, std::memory_order_acq_rel) == 1) { delete _block; }
+            _block = nullptr;
+        }
+
+        Block* _block;
+    };
+}
@@ -0,0 +1,339 @@
+#pragma once
+
+#include "one_of.h"
+
+#include <stddef.h>
+#include <stdexcept>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace one_of
+{
+    /**
+     * Wire format of a OneOf, in host byte order :
+     *  - a header of wire_header_size bytes : the size of the payload on 4 bytes, the index of the tag on 1 byte, 3 reserved bytes
+     *  - the payload, as written by wire_traits<Tag::Type>::write
+     *  - padding up to a multiple of wire_alignment bytes, so that the next encoded OneOf stays aligned
+     * When the buffer is aligned on wire_alignment bytes, payloads are thus aligned too and can be read in place.
+     */
+    static constexpr size_t wire_header_size = 8;
+    static constexpr size_t wire_alignment = 8;
+
+    /**
+     * A view over the characters of an encoded std::string
+     */
+    struct StringView
+    {
+        const char* data;
+        size_t size;
+
+        std::string str() const { return std::string(data, size); }
+    };
+
+    /**
+     * Describes how a type is written to and read from the wire. Specializations must provide :
+     *  - typedef ... view_type : what the handlers of a OneOfView receive
+     *  - static size_t size(const T& value) : the number of bytes written by write
+     *  - static void write(const T& value, char* out)
+     *  - static view_type view(const char* data, size_t size) : reads the payload in place
+     *  - static T read(const char* data, size_t size) : decodes the payload
+     *  - static bool valid_size(size_t size) : whether a payload of this size can be viewed and read, 
+     *    checked by OneOfView::isValid since encoded buffers are untrusted input
+     * The default implementation handles trivially copyable types, which are read in place, 
+     * except pointers : their value is an address, meaningless to the reader.
+     */
+    template<typename T, typename Enable = void>
+    struct wire_traits {};
+
+    template<typename T>
+    struct wire_traits<T, typename std::enable_if<
+        std::is_trivially_copyable<T>::value && !std::is_pointer<T>::value && !std::is_member_pointer<T>::value>::type>
+    {
+        static_assert(alignof(T) <= wire_alignment, "The payload would not be aligned on the wire");
+
+        typedef const T& view_type;
+
+        static size_t size(const T&)                            { return sizeof(T); }
+        static void write(const T& value, char* out)            { memcpy(out, &value, sizeof(T)); }
+        static view_type view(const char* data, size_t)         { return *reinterpret_cast<const T*>(data); }
+        static T read(const char* data, size_t size)            { return view(data, size); }
+        static bool valid_size(size_t size)                     { return size == sizeof(T); }
+    };
+
+    template<>
+    struct wire_traits<std::string>
+    {
+        typedef StringView view_type;
+
+        static size_t size(const std::string& value)            { return value.size(); }
+        static void write(const std::string& value, char* out)  { memcpy(out, value.data(), value.size()); }
+        static view_type view(const char* data, size_t size)    { StringView result = { data, size }; return result; }
+        static std::string read(const char* data, size_t size)  { return std::string(data, size); }
+        static bool valid_size(size_t)                          { return true; }
+    };
+
+namespace details
+{
+    inline size_t wire_padded(size_t size)
+    {
+        return (size + wire_alignment - 1) / wire_alignment * wire_alignment;
+    }
+
+    // The size of the payload is encoded on 4 bytes
+    inline uint32_t wire_payload_size(size_t size)
+    {
+        if (size > UINT32_MAX) { throw std::length_error("one_of::encode : the payload exceeds the 4 GiB the header can describe"); }
+        return static_cast<uint32_t>(size);
+    }
+
+    // The same handler, once per tag
+    template<typename Tag, typename Handler> Handler& for_tag(Handler& handler) { return handler; }
+
+    struct WireSizer
+    {
+        template<typename T> size_t operator()(const T& value) const { return wire_traits<T>::size(value); }
+    };
+
+    struct WireWriter
+    {
+        char* out;
+        template<typename T> void operator()(const T& value) const { wire_traits<T>::write(value, out); }
+    };
+
+    template<typename Tag, typename O>
+    O wire_read(const char* data, size_t size)
+    {
+        return O(Tag{}, wire_traits<typename Tag::Type>::read(data, size));
+    }
+
+    template<typename R, typename Tag, size_t I, typename HandlerTuple>
+    R visit_wire_alternative(const char* data, size_t size, HandlerTuple& handlers)
+    {
+        return get_ref<I>(handlers)(wire_traits<typename Tag::Type>::view(data, size));
+    }
+
+    template<typename R, typename... Tags, size_t... Is, typename HandlerTuple>
+    R visit_wire(const char* data, size_t size, const uint32_t& index, type_list<Tags...>, index_sequence<Is...>, HandlerTuple& handlers)
+    {
+        typedef R (*Entry)(const char*, size_t, HandlerTuple&);
+        static constexpr Entry table[] = { &visit_wire_alternative<R, Tags, Is, HandlerTuple>... };
+        return table[index](data, size, handlers);
+    }
+}
+
+    /**
+     * Allows to visit an encoded OneOf
+     * @tparam V the variant type of the encoded OneOf
+     * @tparam Matched the set of the indices of the tags that have already been matched
+     */
+    template<typename V, typename Matched = details::index_set<>>
+    class WireVisitor
+    {
+    public:
+
+        WireVisitor(const char* payload, const uint32_t& size, const uint32_t& index, const bool& already_found = false) : 
+            _payload(payload), 
+            _size(size),
+            _index(index),
+            _already_found(already_found) {}
+
+        /**
+         * Matches an encoded OneOf with the given Tag
+         * @tparam Tag the tag we want to match
+         * @param cb the function that will be called with a wire_traits<Tag::Type>::view_type if the OneOf matches the tag
+         * @return A visitor for chained calls
+         */
+        template<typename Tag, typename Callback>
+        WireVisitor<V, typename Matched::template insert<details::index_of<Tag, V>::value>> match(Callback&& cb)
+        {
+            static_assert(!Matched::template contains<details::index_of<Tag, V>::value>::value, "Can not match the same tag twice");
+
+            if (details::index_of<Tag, V>::value == _index)
+            {
+                _already_found = true;
+                cb(wire_traits<typename Tag::Type>::view(_payload, _size));
+            }
+            return WireVisitor<V, typename Matched::template insert<details::index_of<Tag, V>::value>>(_payload, _size, _index, _already_found);
+        }
+
+        /**
+         * Defines a fallback function that handles unmatched tags
+         * @param cb in case of an unmatched tag, this function will be called
+         */
+        template<typename Callback>
+        void fallback(Callback&& cb)
+        {
+            if (!_already_found) { cb(); }
+        }
+
+        /**
+         * Asserts that all tags have been matched
+         */
+        void assertMatchIsExhaustive() const
+        {
+            static_assert(Matched::size == details::size_of<V>::value, "Match is not exhaustive");
+        }
+
+    private:
+
+        const char* _payload;
+        const uint32_t _size;
+        const uint32_t _index;
+        bool _already_found;
+    };
+
+    /**
+     * @return the number of bytes needed to encode the given OneOf
+     * @throw std::length_error if the payload is 4 GiB or larger, its size not fitting in the header
+     */
+    template<typename... Tags>
+    size_t encoded_size(const OneOf<Tags...>& value)
+    {
+        details::WireSizer sizer;
+        return wire_header_size + details::wire_padded(details::wire_payload_size(value.visit(details::for_tag<Tags>(sizer)...)));
+    }
+
+    /**
+     * Encodes a OneOf
+     * @param value the OneOf to encode
+     * @param out the buffer to write to, at least encoded_size(value) bytes long
+     * @return the number of bytes written
+     * @throw std::length_error if the payload is 4 GiB or larger, before anything is written
+     */
+    template<typename... Tags>
+    size_t encode(const OneOf<Tags...>& value, char* out)
+    {
+        static_assert(sizeof...(Tags) <= 256, "The index of the tag is encoded on a single byte");
+
+        details::WireSizer sizer;
+        details::WireWriter writer = { out + wire_header_size };
+
+        const uint32_t payload_size = details::wire_payload_size(value.visit(details::for_tag<Tags>(sizer)...));
+        const size_t padded_size = details::wire_padded(payload_size);
+
+        memcpy(out, &payload_size, sizeof(payload_size));
+        out[4] = static_cast<char>(value.index());
+        memset(out + 5, 0, 3);
+        value.visit(details::for_tag<Tags>(writer)...);
+        memset(out + wire_header_size + payload_size, 0, padded_size - payload_size);
+        return wire_header_size + padded_size;
+    }
+
+    /**
+     * Appends an encoded OneOf to a buffer
+     * @param value the OneOf to encode
+     * @param out the buffer to append to
+     */
+    template<typename... Tags>
+    void encode(const OneOf<Tags...>& value, std::vector<char>& out)
+    {
+        const size_t offset = out.size();
+        out.resize(offset + encoded_size(value));
+        encode(value, out.data() + offset);
+    }
+
+    /**
+     * A OneOf encoded in a buffer, that can be matched without decoding its payload
+     * @tparam Tags : the tags of the encoded OneOf
+     */
+    template<typename... Tags>
+    class OneOfView
+    {
+    public:
+
+        typedef details::TaggedUnion<Tags...> Variant;
+
+        /**
+         * @param data the beginning of the encoded OneOf, aligned on wire_alignment bytes
+         */
+        explicit OneOfView(const char* data) : _data(data) {}
+
+        /**
+         * Checks that the encoded OneOf is well formed and fits in the given number of bytes : 
+         * the tag exists, and the size of the payload is valid for its type
+         * @param available the number of readable bytes from the beginning of the encoded OneOf
+         */
+        bool isValid(size_t available) const
+        {
+            typedef bool (*SizeCheck)(size_t);
+            static constexpr SizeCheck valid_sizes[] = { &wire_traits<typename Tags::Type>::valid_size... };
+
+            return available >= wire_header_size && index() < sizeof...(Tags) && encodedSize() <= available && 
+                   valid_sizes[index()](payloadSize());
+        }
+
+        /**
+         * @return the index of the encoded tag, in the order of the tags
+         */
+        uint32_t index() const
+        {
+            return static_cast<uint8_t>(_data[4]);
+        }
+
+        /**
+         * @return the size of the encoded OneOf, the next one (if any) starts right after
+         */
+        size_t encodedSize() const
+        {
+            return wire_header_size + details::wire_padded(payloadSize());
+        }
+
+        /**
+         * @return a view over the next encoded OneOf
+         */
+        OneOfView next() const
+        {
+            return OneOfView(_data + encodedSize());
+        }
+
+        /**
+         * Matches the encoded OneOf with the given tag
+         * @tparam Tag the tag to match
+         * @param cb the function that will be called with a wire_traits<Tag::Type>::view_type if the OneOf matches the tag
+         * @return A visitor for chained calls
+         */
+        template<typename Tag, typename Callback>
+        WireVisitor<Variant, details::index_set<details::index_of<Tag, Variant>::value>> match(Callback&& cb) const
+        {
+            return WireVisitor<Variant>(_data + wire_header_size, payloadSize(), index()).template match<Tag>(std::forward<Callback>(cb));
+        }
+
+        /**
+         * Visits the encoded OneOf with one handler per tag, in the order of the tags
+         * @param handlers the functions to call with a wire_traits<Tag::Type>::view_type, the one matching the encoded tag will be called
+         * @return the value returned by the called handler, converted to the common type of all handlers
+         */
+        template<typename... Handlers>
+        typename details::visit_result<details::type_list<typename wire_traits<typename Tags::Type>::view_type...>, details::type_list<Handlers...>>::type 
+        visit(Handlers&&... handlers) const
+        {
+            typedef typename details::visit_result<details::type_list<typename wire_traits<typename Tags::Type>::view_type...>, details::type_list<Handlers...>>::type Result;
+            details::ref_tuple<Handlers...> handler_refs(handlers...);
+            return details::visit_wire<Result>(_data + wire_header_size, payloadSize(), index(), details::type_list<Tags...>(), details::index_sequence_for<Tags...>(), handler_refs);
+        }
+
+        /**
+         * @return the decoded OneOf
+         */
+        OneOf<Tags...> decode() const
+        {
+            typedef OneOf<Tags...> (*Reader)(const char*, size_t);
+            static constexpr Reader readers[] = { &details::wire_read<Tags, OneOf<Tags...>>... };
+            return readers[index()](_data + wire_header_size, payloadSize());
+        }
+
+    private:
+
+        uint32_t payloadSize() const
+        {
+            uint32_t size;
+            memcpy(&size, _data, sizeof(size));
+            return size;
+        }
+
+        const char* _data;
+    };
+}
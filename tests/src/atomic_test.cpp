@@ -0,0 +1,75 @@
+#include "check.h"
+
+#include <one_of/atomic_one_of.h>
+
+#include <atomic>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+// Too large for a single word, so published through the sequence lock. A torn read breaks the invariant : check == ~sequence
+struct Frame { uint64_t sequence; uint64_t check; };
+ONE_OF_CREATE_ALTERNATIVE(IDLE,    uint64_t)
+ONE_OF_CREATE_ALTERNATIVE(RUNNING, Frame)
+typedef one_of::AtomicOneOf<IDLE, RUNNING> Pipeline;
+
+ONE_OF_CREATE_ALTERNATIVE(CONNECTING, uint32_t)
+ONE_OF_CREATE_ALTERNATIVE(CONNECTED,  uint32_t)
+typedef one_of::AtomicOneOf<CONNECTING, CONNECTED> Connection;
+
+static_assert(!Pipeline::is_always_lock_free, "The pipeline needs the sequence lock");
+
+static Pipeline::value_type make(uint64_t i)
+{
+    if (i % 2) { return Pipeline::value_type(IDLE{}, i); }
+    return Pipeline::value_type(RUNNING{}, Frame{i, ~i});
+}
+
+static bool consistent(const Pipeline::value_type& value)
+{
+    return value.visit(
+        [](const uint64_t&)         { return true; },
+        [](const Frame& frame)      { return frame.check == ~frame.sequence; });
+}
+
+int main()
+{
+    // One writer, several readers checking every snapshot, for a bounded number of writes
+    const uint64_t writes = 200000;
+    const unsigned reader_count = 3;
+
+    Pipeline pipeline(make(0));
+    std::atomic<bool> done(false);
+    std::atomic<bool> torn(false);
+
+    std::vector<std::thread> readers;
+    for (unsigned r = 0; r < reader_count; ++r)
+    {
+        readers.emplace_back([&]()
+        {
+            while (!done.load(std::memory_order_relaxed))
+            {
+                if (!consistent(pipeline.load())) { torn = true; }
+            }
+        });
+    }
+
+    for (uint64_t i = 1; i <= writes; ++i) { pipeline.store(make(i)); }
+    done = true;
+    for (std::thread& reader : readers) { reader.join(); }
+
+    ONE_OF_CHECK(!torn);
+    uint64_t last = 0;
+    pipeline.load().match<RUNNING>([&](const Frame& frame) { last = frame.sequence; });
+    ONE_OF_CHECK(last == writes);
+
+    // The tag is compared before the value is replaced, through the sequence lock and in a single word
+    ONE_OF_CHECK(!pipeline.compare_exchange<IDLE>(make(1)));
+    ONE_OF_CHECK(pipeline.compare_exchange<RUNNING>(make(1)) && pipeline.load().index() == 0);
+
+    Connection connection(Connection::value_type(CONNECTING{}, 1u));
+    ONE_OF_CHECK(!connection.compare_exchange<CONNECTED>(Connection::value_type(CONNECTED{}, 2u)));
+    ONE_OF_CHECK(connection.compare_exchange<CONNECTING>(Connection::value_type(CONNECTED{}, 2u)));
+    ONE_OF_CHECK(connection.exchange(Connection::value_type(CONNECTING{}, 3u)).index() == 1 && connection.load().index() == 0);
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "check.h"
+
+#include <one_of/batch.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+ONE_OF_CREATE_ALTERNATIVE(NUMBER, int)
+ONE_OF_CREATE_ALTERNATIVE(TEXT,   std::string)
+ONE_OF_CREATE_ALTERNATIVE(FLAG,   bool)
+typedef one_of::OneOf<NUMBER, TEXT, FLAG> Element;
+
+// Elements cycling through the tags : 0, "1", true, 3, "4", false...
+std::vector<Element> elements(int count)
+{
+    std::vector<Element> result;
+    for (int i = 0; i < count; ++i)
+    {
+        switch (i % 3)
+        {
+            case 0:  result.push_back(Element(NUMBER{}, i)); break;
+            case 1:  result.push_back(Element(TEXT{}, std::to_string(i))); break;
+            default: result.push_back(Element(FLAG{}, i % 2 == 0)); break;
+        }
+    }
+    return result;
+}
+
+int main()
+{
+    // visit_batch calls each handler on all the elements of its tag, in the order of the range
+    std::vector<Element> batch = elements(9);
+    std::string order;
+    one_of::visit_batch(batch.begin(), batch.end(),
+        [&](int& n)         { order += std::to_string(n) + ","; n *= 10; },
+        [&](std::string& t) { order += t + ","; },
+        [&](bool& b)        { order += b ? "T," : "F,"; });
+    ONE_OF_CHECK(order == "0,3,6,1,4,7,T,F,T,");
+    ONE_OF_CHECK(batch[3].value_or<NUMBER>(0) == 30);
+
+    // parallel_visit_batch visits every element once, from several threads
+    std::vector<Element> large = elements(30000);
+    std::atomic<long long> numbers(0);
+    std::atomic<size_t> texts(0);
+    std::atomic<size_t> flags(0);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    for (int call = 0; call < 50; ++call)
+    {
+        one_of::parallel_visit_batch(large.begin(), large.end(), 4,
+            [&](int& n)         { numbers += n; },
+            [&](std::string&)   { ++texts; },
+            [&](bool&)          { std::lock_guard<std::mutex> lock(mutex); threads.insert(std::this_thread::get_id()); ++flags; });
+    }
+    ONE_OF_CHECK(numbers == 50LL * (0 + 29997) * 10000 / 2);
+    ONE_OF_CHECK(texts == 50 * 10000 && flags == 50 * 10000);
+
+    // The calls share a pool instead of starting their own threads
+    const size_t hardware = std::max<unsigned>(std::thread::hardware_concurrency(), 2);
+    ONE_OF_CHECK(threads.size() <= hardware);
+
+    // A handler may itself visit a batch in parallel, even while it runs on the threads of the pool
+    std::vector<Element> inner = elements(3000);
+    std::atomic<size_t> nested(0);
+    one_of::parallel_visit_batch(large.begin(), large.end(), 4,
+        [&](int& n)         { if (n % 3000 == 0) { one_of::parallel_visit_batch(inner.begin(), inner.end(), 4, [&](int&) { ++nested; }, [](std::string&) {}, [](bool&) {}); } },
+        [](std::string&)    {},
+        [](bool&)           {});
+    ONE_OF_CHECK(nested == 10 * 1000);
+
+    // An exception thrown by a handler is rethrown once all the threads are done
+    bool thrown = false;
+    try
+    {
+        one_of::parallel_visit_batch(large.begin(), large.end(), 4,
+            [](int&)            {},
+            [](std::string& t)  { if (t == "29998") { throw std::runtime_error("handler"); } },
+            [](bool&)           {});
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    ONE_OF_CHECK(thrown);
+
+    return 0;
+}
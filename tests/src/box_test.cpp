@@ -0,0 +1,91 @@
+// The assertions of Box are tested, whatever the build type
+#undef NDEBUG
+
+#include "check.h"
+
+#include <one_of/one_of.h>
+
+#include <csignal>
+#include <cstdlib>
+#include <string.h>
+#include <string>
+#include <utility>
+
+struct Blob
+{
+    char bytes[256];
+};
+
+ONE_OF_CREATE_ALTERNATIVE(NUMBER, int)
+ONE_OF_CREATE_BOXED_ALTERNATIVE(BLOB, Blob)
+typedef one_of::OneOf<NUMBER, BLOB> Value;
+
+typedef one_of::Box<Blob> BlobBox;
+
+// Two sizes of the same size class of the pool, the smaller one boxed first
+struct Bytes20 { char bytes[20]; };
+struct Bytes32 { char bytes[32]; };
+
+static Value makeBlob(char fill)
+{
+    Blob blob;
+    memset(blob.bytes, fill, sizeof(blob.bytes));
+    return Value(BLOB{}, blob);
+}
+
+static char firstByte(const Value& value)
+{
+    char result = 0;
+    value.match<BLOB>([&](const Blob& blob) { result = blob.bytes[0]; });
+    return result;
+}
+
+static void assertionFailed(int)
+{
+    std::_Exit(0);
+}
+
+// With "match-moved-from", matches a moved-from OneOf, which must fail an assertion
+int main(int argc, char** argv)
+{
+    Value source = makeBlob('a');
+    Value moved(std::move(source));
+    ONE_OF_CHECK(firstByte(moved) == 'a');
+
+    // The box of the moved-from OneOf is empty, and only reached through the assertion
+    ONE_OF_CHECK(static_cast<const BlobBox*>(one_of::details::OneOfAccess::payload(source))->empty());
+    ONE_OF_CHECK(!static_cast<const BlobBox*>(one_of::details::OneOfAccess::payload(moved))->empty());
+
+    if (argc > 1 && std::string(argv[1]) == "match-moved-from")
+    {
+        std::signal(SIGABRT, &assertionFailed);
+        firstByte(source);
+        return 1;
+    }
+
+    // The moved-from OneOf can be assigned, then used again
+    source = makeBlob('b');
+    ONE_OF_CHECK(firstByte(source) == 'b');
+
+    Value emptied(std::move(source));
+    source.emplace<NUMBER>(3);
+    ONE_OF_CHECK(source.index() == 0);
+
+    // And destroyed, which releases nothing
+    {
+        Value destroyed = makeBlob('c');
+        Value kept(std::move(destroyed));
+    }
+
+    // A block cached after a smaller value of its size class holds a larger one of the same class
+    {
+        one_of::Box<Bytes20> small;
+        memset(small.get().bytes, 's', sizeof(Bytes20));
+    }
+    {
+        one_of::Box<Bytes32> large;
+        memset(large.get().bytes, 'l', sizeof(Bytes32));
+        ONE_OF_CHECK(large.get().bytes[sizeof(Bytes32) - 1] == 'l');
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "check.h"
+
+#include <one_of/channel.h>
+
+#include <stdexcept>
+
+struct Fragile
+{
+    explicit Fragile(bool fail) : value(1) { if (fail) { throw std::runtime_error("construction"); } }
+    int value;
+};
+
+ONE_OF_CREATE_ALTERNATIVE(NUMBER, int)
+ONE_OF_CREATE_ALTERNATIVE(FRAGILE, Fragile)
+
+static_assert(alignof(one_of::details::PaddedIndex) == one_of::cache_line_size, "The indices must start their own cache line");
+static_assert(sizeof(one_of::details::PaddedIndex) == one_of::cache_line_size, "The indices must fill their cache line");
+
+// A constructor throwing in a producer sends nothing, and the channel keeps working
+template<typename Channel>
+void checkThrowingProducer()
+{
+    Channel channel(2);
+
+    bool thrown = false;
+    try { channel.template try_emplace<FRAGILE>(true); }
+    catch (const std::runtime_error&) { thrown = true; }
+    ONE_OF_CHECK(thrown);
+
+    // Enough values to wrap around the ring, through the slot that was skipped
+    for (int i = 0; i < 5; ++i)
+    {
+        ONE_OF_CHECK(channel.template try_emplace<NUMBER>(i));
+
+        int received = -1;
+        ONE_OF_CHECK(channel.try_consume([&](typename Channel::value_type& value) { value.template match<NUMBER>([&](int n) { received = n; }); }));
+        ONE_OF_CHECK(received == i);
+        ONE_OF_CHECK(!channel.try_consume([](typename Channel::value_type&) {}));
+    }
+
+    ONE_OF_CHECK(channel.template try_emplace<FRAGILE>(false));
+    ONE_OF_CHECK(channel.template try_emplace<NUMBER>(7));
+    ONE_OF_CHECK(!channel.template try_emplace<NUMBER>(8));
+}
+
+int main()
+{
+    checkThrowingProducer<one_of::Channel<NUMBER, FRAGILE>>();
+    checkThrowingProducer<one_of::SpscChannel<NUMBER, FRAGILE>>();
+    return 0;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Unlike assert, not disabled by NDEBUG
+#define ONE_OF_CHECK(condition) \
+    do { if (!(condition)) { std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); std::exit(1); } } while (false)
@@ -0,0 +1,75 @@
+#include "check.h"
+
+#include <one_of/one_of.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+
+ONE_OF_CREATE_ALTERNATIVE(NUMBER, int)
+ONE_OF_CREATE_ALTERNATIVE(TEXT,   std::string)
+ONE_OF_CREATE_ALTERNATIVE(OWNED,  std::unique_ptr<int>)
+ONE_OF_CREATE_ALTERNATIVE(ERROR,  std::string)
+
+typedef one_of::OneOf<TEXT, NUMBER> Parsed;
+typedef one_of::OneOf<ERROR, NUMBER, TEXT> Checked;
+typedef one_of::OneOf<OWNED, NUMBER> Owning;
+
+// Keeps the positive numbers, turns the others into errors
+Checked positive(int number)
+{
+    if (number > 0) { return Checked(NUMBER{}, number); }
+    return Checked(ERROR{}, std::string("not positive"));
+}
+
+int main()
+{
+    const Parsed number(NUMBER{}, 7);
+    Parsed text(TEXT{}, std::string("seven"));
+
+    // get_if returns the address of the active payload, and null for the other tags
+    ONE_OF_CHECK(number.get_if<NUMBER>() != nullptr && *number.get_if<NUMBER>() == 7);
+    ONE_OF_CHECK(number.get_if<TEXT>() == nullptr);
+    *text.get_if<TEXT>() += "!";
+    ONE_OF_CHECK(*text.get_if<TEXT>() == "seven!");
+
+    // value_or copies the payload of the active tag, or converts the fallback
+    ONE_OF_CHECK(number.value_or<NUMBER>(0) == 7);
+    ONE_OF_CHECK(number.value_or<TEXT>("none") == "none");
+    ONE_OF_CHECK(Parsed(text).value_or<TEXT>("none") == "seven!");
+
+    // value_or on a temporary moves the payload out
+    Owning owning(OWNED{}, std::unique_ptr<int>(new int(3)));
+    const std::unique_ptr<int> owned = std::move(owning).value_or<OWNED>(nullptr);
+    ONE_OF_CHECK(owned && *owned == 3);
+    ONE_OF_CHECK(Owning(NUMBER{}, 1).value_or<OWNED>(nullptr) == nullptr);
+
+    // map transforms the payload of its tag and keeps the other alternatives
+    const Parsed doubled = number.map<NUMBER>([](int n) { return n * 2; });
+    ONE_OF_CHECK(doubled.index() == 1 && doubled.value_or<NUMBER>(0) == 14);
+    const Parsed untouched = number.map<TEXT>([](const std::string& t) { return t + t; });
+    ONE_OF_CHECK(untouched.index() == 1 && untouched.value_or<NUMBER>(0) == 7);
+
+    const Parsed shouted = std::move(text).map<TEXT>([](std::string&& t) { t += "!"; return std::move(t); });
+    ONE_OF_CHECK(shouted.value_or<TEXT>("") == "seven!!");
+
+    const Owning incremented = Owning(OWNED{}, std::unique_ptr<int>(new int(4)))
+        .map<OWNED>([](std::unique_ptr<int>&& p) { ++*p; return std::move(p); });
+    ONE_OF_CHECK(*incremented.get_if<OWNED>() && **incremented.get_if<OWNED>() == 5);
+
+    // and_then chains a computation on its tag, and converts the other alternatives to the result type
+    const Checked checked = number.and_then<NUMBER>(positive);
+    ONE_OF_CHECK(checked.index() == 1 && checked.value_or<NUMBER>(0) == 7);
+
+    const Checked rejected = Parsed(NUMBER{}, -1).and_then<NUMBER>(positive);
+    ONE_OF_CHECK(rejected.index() == 0 && rejected.value_or<ERROR>("") == "not positive");
+
+    const Parsed words(TEXT{}, std::string("words"));
+    const Checked kept = words.and_then<NUMBER>(positive);
+    ONE_OF_CHECK(kept.index() == 2 && kept.value_or<TEXT>("") == "words");
+
+    const Checked moved = Parsed(TEXT{}, std::string("moved")).and_then<NUMBER>(positive);
+    ONE_OF_CHECK(moved.index() == 2 && moved.value_or<TEXT>("") == "moved");
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "check.h"
+
+#include <one_of/hash.h>
+#include <one_of/one_of.h>
+
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <unordered_set>
+
+// No padding, compared member by member
+struct Point { int32_t x; int32_t y; };
+inline bool operator==(const Point& a, const Point& b) { return a.x == b.x && a.y == b.y; }
+namespace one_of { template<> struct is_trivially_comparable<Point> : std::true_type {}; }
+
+ONE_OF_CREATE_ALTERNATIVE(NUMBER, int)
+ONE_OF_CREATE_ALTERNATIVE(TEXT,   std::string)
+ONE_OF_CREATE_ALTERNATIVE(OTHER,  int)
+typedef one_of::OneOf<NUMBER, TEXT, OTHER> Value;
+
+ONE_OF_CREATE_ALTERNATIVE(POINT, Point)
+ONE_OF_CREATE_ALTERNATIVE(ID,    uint64_t)
+typedef one_of::OneOf<POINT, ID> Trivial;
+
+static_assert(one_of::details::all_trivially_comparable<POINT, ID>::value, "Points and integers are compared as bytes");
+static_assert(!one_of::details::all_trivially_comparable<NUMBER, TEXT, OTHER>::value, "Strings are compared with their operators");
+
+int main()
+{
+    // The index is compared first, whatever the payloads
+    const Value number(NUMBER{}, 100);
+    const Value text(TEXT{}, std::string("a"));
+    const Value other(OTHER{}, 0);
+    ONE_OF_CHECK(number < text && text < other && number < other);
+    ONE_OF_CHECK(other > number && !(number > text) && number != text);
+
+    // Then the payloads of the same alternative
+    ONE_OF_CHECK(Value(TEXT{}, std::string("a")) == text && Value(TEXT{}, std::string("b")) != text);
+    ONE_OF_CHECK(Value(TEXT{}, std::string("a")) < Value(TEXT{}, std::string("b")));
+    ONE_OF_CHECK(Value(NUMBER{}, 1) <= Value(NUMBER{}, 1) && Value(NUMBER{}, 2) >= Value(NUMBER{}, 1));
+
+    // The same payload under two tags is not the same value
+    ONE_OF_CHECK(Value(NUMBER{}, 0) != other);
+
+    // Equal values hash equally, and the hash depends on the tag
+    std::hash<Value> hash;
+    ONE_OF_CHECK(hash(Value(TEXT{}, std::string("a"))) == hash(text));
+    ONE_OF_CHECK(hash(Value(NUMBER{}, 0)) != hash(other));
+
+    // Trivially comparable payloads are compared and hashed as bytes
+    const Trivial point(POINT{}, Point{1, 2});
+    ONE_OF_CHECK(point == Trivial(POINT{}, Point{1, 2}) && point != Trivial(POINT{}, Point{2, 1}));
+    ONE_OF_CHECK(std::hash<Trivial>()(point) == std::hash<Trivial>()(Trivial(POINT{}, Point{1, 2})));
+
+    // OneOfs are keys of unordered containers
+    std::unordered_set<Value> seen;
+    ONE_OF_CHECK(seen.insert(text).second && seen.insert(number).second && seen.insert(other).second);
+    ONE_OF_CHECK(!seen.insert(Value(TEXT{}, std::string("a"))).second && seen.size() == 3);
+    return 0;
+}
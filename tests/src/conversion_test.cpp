@@ -0,0 +1,80 @@
+#include "check.h"
+
+#include <one_of/one_of.h>
+
+#include <string>
+#include <utility>
+
+struct Blob
+{
+    std::string text;
+};
+
+ONE_OF_CREATE_ALTERNATIVE(NUMBER, int)
+ONE_OF_CREATE_ALTERNATIVE(TEXT,   std::string)
+ONE_OF_CREATE_ALTERNATIVE(NONE,   int)
+ONE_OF_CREATE_BOXED_ALTERNATIVE(BLOB, Blob)
+
+typedef one_of::OneOf<TEXT, NUMBER> Narrow;
+typedef one_of::OneOf<NONE, NUMBER, BLOB, TEXT> Wide;
+typedef one_of::OneOf<BLOB, NUMBER> Boxed;
+
+template<typename O>
+std::string text(const O& value)
+{
+    std::string result;
+    value.template match<TEXT>([&](const std::string& t) { result = t; });
+    return result;
+}
+
+template<typename O>
+std::string blob(const O& value)
+{
+    std::string result;
+    value.template match<BLOB>([&](const Blob& b) { result = b.text; });
+    return result;
+}
+
+int main()
+{
+    // Widening keeps the tag, whatever its position in the wider OneOf
+    const Narrow number(NUMBER{}, 7);
+    const Wide widened(number);
+    ONE_OF_CHECK(widened.index() == 1);
+    int n = 0;
+    widened.match<NUMBER>([&](int v) { n = v; });
+    ONE_OF_CHECK(n == 7);
+
+    Narrow moved_text(TEXT{}, std::string("moved"));
+    const Wide widened_text(std::move(moved_text));
+    ONE_OF_CHECK(widened_text.index() == 3 && text(widened_text) == "moved");
+
+    // Narrowing succeeds for the tags of the target only
+    const Wide wide_text(TEXT{}, std::string("text"));
+    bool narrowed = false;
+    wide_text.try_narrow<Narrow>().match<one_of::Narrowed<Narrow>>([&](const Narrow& value) { narrowed = text(value) == "text"; });
+    ONE_OF_CHECK(narrowed && text(wide_text) == "text");
+
+    bool not_narrowed = false;
+    const Wide none(NONE{}, 1);
+    none.try_narrow<Narrow>().match<one_of::NotNarrowed>([&](const one_of::NotNarrowed&) { not_narrowed = true; });
+    ONE_OF_CHECK(not_narrowed);
+
+    narrowed = false;
+    Wide(TEXT{}, std::string("rvalue")).try_narrow<Narrow>().match<one_of::Narrowed<Narrow>>([&](const Narrow& value) { narrowed = text(value) == "rvalue"; });
+    ONE_OF_CHECK(narrowed);
+
+    // Boxed payloads are copied through their value, and moved through their box
+    const Boxed boxed(BLOB{}, Blob{ "boxed" });
+    const Wide copied(boxed);
+    ONE_OF_CHECK(blob(copied) == "boxed" && blob(boxed) == "boxed");
+
+    narrowed = false;
+    copied.try_narrow<Boxed>().match<one_of::Narrowed<Boxed>>([&](const Boxed& value) { narrowed = blob(value) == "boxed"; });
+    ONE_OF_CHECK(narrowed && blob(copied) == "boxed");
+
+    Boxed source(BLOB{}, Blob{ "source" });
+    const Wide moved_blob(std::move(source));
+    ONE_OF_CHECK(blob(moved_blob) == "source");
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include "check.h"
+
+#include <one_of/counters.h>
+#include <one_of/one_of.h>
+
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+ONE_OF_CREATE_ALTERNATIVE(NUMBER, int)
+ONE_OF_CREATE_ALTERNATIVE(TEXT,   std::string)
+typedef one_of::OneOf<NUMBER, TEXT> Value;
+namespace one_of { template<> struct instrumentation<Value> : Counters<Value> {}; }
+
+// Trivial alternatives, with and without instrumentation
+ONE_OF_CREATE_ALTERNATIVE(PLAIN, int)
+typedef one_of::OneOf<PLAIN, NUMBER> Plain;
+typedef one_of::OneOf<NUMBER, PLAIN> Counted;
+namespace one_of { template<> struct instrumentation<Counted> : Counters<Counted> {}; }
+
+static_assert(std::is_trivially_copyable<Plain>::value, "Without instrumentation, OneOfs of trivial alternatives are trivially copyable");
+static_assert(!std::is_trivially_copyable<Counted>::value, "Copies of instrumented OneOfs are counted");
+
+typedef one_of::Counters<Value> ValueCounters;
+
+int main()
+{
+    std::vector<one_of::InstrumentationEvent> events;
+    ValueCounters::setSink([&](const one_of::InstrumentationEvent& event) { events.push_back(event); });
+
+    Value value(TEXT{}, std::string("text"));
+    Value copy(value);
+    copy.emplace<NUMBER>(3);
+    copy.match<NUMBER>([](int&) {}).match<TEXT>([](std::string&) {});
+    const size_t size = value.visit([](const int&) { return size_t(0); }, [](const std::string& text) { return text.size(); });
+    ONE_OF_CHECK(size == 4);
+
+    // Each event is counted on its alternative
+    const one_of::InstrumentationReport report = ValueCounters::report();
+    ONE_OF_CHECK(report.alternatives.size() == 2);
+    const one_of::AlternativeStats& number = report.alternatives[0];
+    const one_of::AlternativeStats& text = report.alternatives[1];
+    ONE_OF_CHECK(text.constructed == 1 && text.copied == 1 && text.emplaced == 0 && text.matched == 1);
+    ONE_OF_CHECK(number.constructed == 0 && number.copied == 0 && number.emplaced == 1 && number.matched == 1);
+    ONE_OF_CHECK(report.alternatives[1].tag.find("TEXT") != std::string::npos);
+
+    // And forwarded to the sink, in order
+    ONE_OF_CHECK(events.size() == 5);
+    ONE_OF_CHECK(events[0].kind == one_of::InstrumentationEvent::Constructed && events[0].index == 1);
+    ONE_OF_CHECK(events[1].kind == one_of::InstrumentationEvent::Copied && events[1].index == 1);
+    ONE_OF_CHECK(events[2].kind == one_of::InstrumentationEvent::Emplaced && events[2].index == 0);
+    ONE_OF_CHECK(events[3].kind == one_of::InstrumentationEvent::Matched && events[3].index == 0);
+    ONE_OF_CHECK(events[4].kind == one_of::InstrumentationEvent::Matched && events[4].index == 1);
+
+    // The instrumented types are registered when they record their first event
+    const std::vector<one_of::InstrumentationReport> reports = one_of::instrumentation_reports();
+    ONE_OF_CHECK(reports.size() == 1 && reports[0].type == report.type);
+
+    // The hot alternatives are the ones above the given share of the matches
+    std::ostringstream header;
+    one_of::write_hot_alternatives(header, report, 0.5);
+    ONE_OF_CHECK(header.str().find("is_hot<") != std::string::npos);
+
+    ValueCounters::setSink(one_of::InstrumentationSink());
+    ValueCounters::reset();
+    ONE_OF_CHECK(ValueCounters::report().alternatives[1].constructed == 0);
+    return 0;
+}
@@ -0,0 +1,15 @@
+// Must not compile : the dispatcher has no handler for TEXT
+#include <one_of/dispatcher.h>
+
+#include <string>
+
+ONE_OF_CREATE_ALTERNATIVE(NUMBER, int)
+ONE_OF_CREATE_ALTERNATIVE(TEXT,   std::string)
+
+int main()
+{
+    auto dispatcher = one_of::Dispatcher<int, NUMBER, TEXT>::builder()
+        .on<NUMBER>(1, [](int value) { return value; })
+        .build();
+    return dispatcher->submit(one_of::OneOf<NUMBER, TEXT>(NUMBER{}, 0)).get();
+}
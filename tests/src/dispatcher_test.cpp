@@ -0,0 +1,54 @@
+#include "check.h"
+
+#include <one_of/dispatcher.h>
+
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+ONE_OF_CREATE_ALTERNATIVE(SQUARE, int)
+ONE_OF_CREATE_ALTERNATIVE(LENGTH, std::string)
+ONE_OF_CREATE_ALTERNATIVE(FAIL,   int)
+typedef one_of::Dispatcher<size_t, SQUARE, LENGTH, FAIL> Dispatcher;
+
+// A stateful handler, whose call operator is not const : registered on a single thread
+struct Counter
+{
+    size_t calls = 0;
+    size_t operator()(const std::string& text) { ++calls; return text.size() * 1000 + calls; }
+};
+
+int main()
+{
+    auto dispatcher = Dispatcher::builder()
+        .on<SQUARE>(2, [](int value) { return static_cast<size_t>(value * value); })
+        .on<LENGTH>(1, Counter())
+        .on<FAIL>(1,   [](int) -> size_t { throw std::runtime_error("failed"); })
+        .build();
+
+    // Each OneOf is handled by the handler of its alternative
+    std::vector<std::future<size_t>> squares;
+    for (int i = 0; i < 100; ++i) { squares.push_back(dispatcher->submit(Dispatcher::value_type(SQUARE{}, i))); }
+    for (int i = 0; i < 100; ++i) { ONE_OF_CHECK(squares[i].get() == static_cast<size_t>(i * i)); }
+
+    // The state of the single threaded handler is kept between the calls
+    std::future<size_t> first = dispatcher->submit(Dispatcher::value_type(LENGTH{}, std::string("ab")));
+    ONE_OF_CHECK(first.get() == 2001);
+    std::future<size_t> second = dispatcher->submit(Dispatcher::value_type(LENGTH{}, std::string("abc")));
+    ONE_OF_CHECK(second.get() == 3002);
+
+    // The exception of a handler is given to the future
+    bool thrown = false;
+    try { dispatcher->submit(Dispatcher::value_type(FAIL{}, 0)).get(); }
+    catch (const std::runtime_error&) { thrown = true; }
+    ONE_OF_CHECK(thrown);
+
+    // Pending tasks run before the dispatcher is destroyed
+    std::vector<std::future<size_t>> pending;
+    for (int i = 0; i < 100; ++i) { pending.push_back(dispatcher->submit(Dispatcher::value_type(SQUARE{}, 2))); }
+    dispatcher.reset();
+    for (std::future<size_t>& result : pending) { ONE_OF_CHECK(result.get() == 4); }
+    return 0;
+}
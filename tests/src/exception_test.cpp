@@ -0,0 +1,95 @@
+#include "check.h"
+
+#include <one_of/one_of.h>
+
+#include <stdexcept>
+#include <utility>
+
+static int destroyed = 0;
+static int live = 0;
+
+struct Tracked
+{
+    Tracked() noexcept { ++live; }
+    Tracked(const Tracked&) noexcept { ++live; }
+    ~Tracked() { ++destroyed; --live; }
+};
+
+struct ThrowsOnCopy
+{
+    ThrowsOnCopy() {}
+    ThrowsOnCopy(const ThrowsOnCopy&) { throw std::runtime_error("copy"); }
+    ThrowsOnCopy(ThrowsOnCopy&&) { throw std::runtime_error("move"); }
+};
+
+// Can be moved without throwing, so that it is copied aside before the active alternative is destroyed
+struct ThrowsOnCopyOnly
+{
+    ThrowsOnCopyOnly() {}
+    ThrowsOnCopyOnly(const ThrowsOnCopyOnly&) { throw std::runtime_error("copy"); }
+    ThrowsOnCopyOnly(ThrowsOnCopyOnly&&) noexcept {}
+};
+
+ONE_OF_CREATE_ALTERNATIVE(TRACKED,       Tracked)
+ONE_OF_CREATE_ALTERNATIVE(THROWING,      ThrowsOnCopy)
+ONE_OF_CREATE_ALTERNATIVE(COPY_THROWING, ThrowsOnCopyOnly)
+typedef one_of::OneOf<TRACKED, THROWING> Value;
+typedef one_of::OneOf<THROWING> Narrow;
+typedef one_of::OneOf<TRACKED, COPY_THROWING> Strong;
+
+// Returns whether constructing a OneOf with the given function threw, 
+// checking that no alternative has been destroyed (the first one, TRACKED, was never constructed)
+template<typename Construct>
+bool throwsWithoutDestroying(Construct construct)
+{
+    destroyed = 0;
+    bool thrown = false;
+    try { construct(); }
+    catch (const std::runtime_error&) { thrown = true; }
+    ONE_OF_CHECK(destroyed == 0);
+    return thrown;
+}
+
+// Returns whether replacing the alternative of a OneOf holding TRACKED threw, 
+// checking that the OneOf then holds TRACKED again and that every Tracked was destroyed exactly once
+template<typename O, typename Replace>
+bool throwsAndRecovers(Replace replace)
+{
+    bool thrown = false;
+    {
+        O value(TRACKED{});
+        try { replace(value); }
+        catch (const std::runtime_error&) { thrown = true; }
+        ONE_OF_CHECK(value.index() == 0 && live == 1);
+    }
+    ONE_OF_CHECK(live == 0);
+    return thrown;
+}
+
+int main()
+{
+    Value value(THROWING{});
+
+    ONE_OF_CHECK(throwsWithoutDestroying([&] { Value copy(value); }));
+    ONE_OF_CHECK(throwsWithoutDestroying([&] { Value moved(std::move(value)); }));
+
+    // Widening constructs the payload the same way
+    Narrow narrow(THROWING{});
+    ONE_OF_CHECK(throwsWithoutDestroying([&] { Value widened(narrow); }));
+    ONE_OF_CHECK(throwsWithoutDestroying([&] { Value widened(std::move(narrow)); }));
+
+    // The new alternative can not be constructed aside : the OneOf falls back to TRACKED, its nothrow default constructible alternative
+    const ThrowsOnCopy payload;
+    ONE_OF_CHECK(throwsAndRecovers<Value>([&](Value& v) { v.emplace<THROWING>(payload); }));
+    ONE_OF_CHECK(throwsAndRecovers<Value>([&](Value& v) { v = value; }));
+    ONE_OF_CHECK(throwsAndRecovers<Value>([&](Value& v) { Value other(THROWING{}); v = std::move(other); }));
+
+    // The new alternative is constructed aside, and the OneOf keeps its alternative
+    const ThrowsOnCopyOnly copy_throwing;
+    const Strong strong(COPY_THROWING{});
+    destroyed = 0;
+    ONE_OF_CHECK(throwsAndRecovers<Strong>([&](Strong& s) { s.emplace<COPY_THROWING>(copy_throwing); }));
+    ONE_OF_CHECK(throwsAndRecovers<Strong>([&](Strong& s) { s = strong; }));
+    ONE_OF_CHECK(destroyed == 2);   // Only the two Tracked alternatives, once their OneOfs went out of scope
+    return 0;
+}
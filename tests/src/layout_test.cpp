@@ -0,0 +1,76 @@
+#include "check.h"
+
+#include <one_of/layout.h>
+#include <one_of/one_of.h>
+
+#include <cstdio>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+struct Empty {};
+enum class Color : uint8_t { RED, GREEN, BLUE };
+
+// Raw values 3 to 255 are never taken by a Color
+namespace one_of { template<> struct niche_traits<Color> : sentinel_niches<uint8_t, 3, 253> {}; }
+
+ONE_OF_CREATE_ALTERNATIVE(U8,       uint8_t)
+ONE_OF_CREATE_ALTERNATIVE(U16,      uint16_t)
+ONE_OF_CREATE_ALTERNATIVE(SIZE,     size_t)
+ONE_OF_CREATE_ALTERNATIVE(TEXT,     std::string)
+ONE_OF_CREATE_ALTERNATIVE(NONE,     Empty)
+ONE_OF_CREATE_ALTERNATIVE(UNKNOWN,  Empty)
+ONE_OF_CREATE_ALTERNATIVE(COLOR,    Color)
+
+typedef one_of::OneOf<U8, U16> Small;
+typedef one_of::OneOf<NONE, COLOR, UNKNOWN> Niche;
+typedef one_of::OneOf<SIZE, NONE> Found;
+typedef one_of::OneOf<TEXT, NONE, SIZE> Mixed;
+
+// The index is stored in a uint8_t, next to payloads aligned on 2 bytes (8 bytes with a uint32_t index)
+static_assert(sizeof(Small) == 4 && alignof(Small) == 2, "The index must be stored in the smallest integer");
+
+// The empty alternatives are encoded in the unused values of the Color, so no index is stored (8 bytes with a uint32_t index)
+static_assert(sizeof(Niche) == 1 && alignof(Niche) == 1, "The index must be stored in the niches of the dataful alternative");
+
+// size_t declares no niche, and the index can not be stored in the padding of the payload
+static_assert(sizeof(Found) == 2 * sizeof(size_t), "");
+static_assert(sizeof(Mixed) == sizeof(std::string) + sizeof(size_t), "");
+
+template<typename O>
+void print(const char* name)
+{
+    std::printf("%-40s sizeof=%zu alignof=%zu\n", name, sizeof(O), alignof(O));
+}
+
+// The measured offsets keep the discriminant and the payload apart
+template<typename O>
+bool separated()
+{
+    typedef one_of::layout<O> Layout;
+    return Layout::discriminant_offset() + Layout::discriminant_size <= Layout::payload_offset() ||
+           Layout::payload_offset() + Layout::largest <= Layout::discriminant_offset();
+}
+
+int main()
+{
+    print<Small>("OneOf<uint8_t, uint16_t>");
+    print<Niche>("OneOf<Empty, Color (niche), Empty>");
+    print<Found>("OneOf<size_t, Empty>");
+    print<Mixed>("OneOf<std::string, Empty, size_t>");
+
+    // The niches keep the alternatives apart
+    Niche none(NONE{});
+    Niche color(COLOR{}, Color::BLUE);
+    Niche unknown(UNKNOWN{});
+    ONE_OF_CHECK(none.index() == 0 && color.index() == 1 && unknown.index() == 2);
+
+    Color value = Color::RED;
+    color.match<COLOR>([&](const Color& c) { value = c; });
+    ONE_OF_CHECK(value == Color::BLUE);
+
+    ONE_OF_CHECK(separated<Small>() && separated<Found>() && separated<Mixed>());
+    ONE_OF_CHECK(one_of::layout<Small>::payload_offset() == 2 && one_of::layout<Found>::payload_offset() == sizeof(size_t));
+    ONE_OF_CHECK(one_of::layout<Niche>::discriminant_offset() == one_of::layout<Niche>::payload_offset());
+    return 0;
+}
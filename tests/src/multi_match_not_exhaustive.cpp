@@ -0,0 +1,16 @@
+// Must not compile : the match covers 3 of the 4 combinations of tags, without a fallback
+#include <one_of/multi_match.h>
+
+ONE_OF_CREATE_ALTERNATIVE(A, int)
+ONE_OF_CREATE_ALTERNATIVE(B, int)
+typedef one_of::OneOf<A, B> Value;
+
+int main()
+{
+    const Value a(A{}, 1);
+    const Value b(B{}, 2);
+    return one_of::match2(a, b,
+        one_of::on<A, A>([](const int&, const int&) { return 0; }),
+        one_of::on<A, B>([](const int&, const int&) { return 1; }),
+        one_of::on<B, A>([](const int&, const int&) { return 2; }));
+}
@@ -0,0 +1,67 @@
+#include "check.h"
+
+#include <one_of/multi_match.h>
+
+#include <string>
+
+ONE_OF_CREATE_ALTERNATIVE(IDLE,    int)
+ONE_OF_CREATE_ALTERNATIVE(RUNNING, std::string)
+typedef one_of::OneOf<IDLE, RUNNING> State;
+
+ONE_OF_CREATE_ALTERNATIVE(START, std::string)
+ONE_OF_CREATE_ALTERNATIVE(STOP,  int)
+ONE_OF_CREATE_ALTERNATIVE(PING,  int)
+typedef one_of::OneOf<START, STOP, PING> Event;
+
+ONE_OF_CREATE_ALTERNATIVE(LOW,  int)
+ONE_OF_CREATE_ALTERNATIVE(HIGH, int)
+typedef one_of::OneOf<LOW, HIGH> Priority;
+
+// Covers all the 6 combinations of tags, each returning its own number
+static int combination(const State& state, const Event& event)
+{
+    return one_of::match2(state, event,
+        one_of::on<IDLE, START>([](const int&, const std::string&)              { return 0; }),
+        one_of::on<IDLE, STOP>([](const int&, const int&)                       { return 1; }),
+        one_of::on<IDLE, PING>([](const int&, const int&)                       { return 2; }),
+        one_of::on<RUNNING, START>([](const std::string&, const std::string&)   { return 3; }),
+        one_of::on<RUNNING, STOP>([](const std::string&, const int&)            { return 4; }),
+        one_of::on<RUNNING, PING>([](const std::string&, const int&)            { return 5; }));
+}
+
+int main()
+{
+    const State idle(IDLE{}, 1);
+    const State running(RUNNING{}, std::string("job"));
+    const Event start(START{}, std::string("next"));
+    const Event stop(STOP{}, 0);
+    const Event ping(PING{}, 0);
+
+    ONE_OF_CHECK(combination(idle, start) == 0 && combination(idle, stop) == 1 && combination(idle, ping) == 2);
+    ONE_OF_CHECK(combination(running, start) == 3 && combination(running, stop) == 4 && combination(running, ping) == 5);
+
+    // The handlers receive the payloads, mutable when the OneOfs are
+    State state(IDLE{}, 1);
+    Event event(START{}, std::string("job"));
+    const State next = one_of::match2(state, event,
+        one_of::on<IDLE, START>([](int& count, std::string& job)    { ++count; return State(RUNNING{}, job); }),
+        one_of::otherwise([&]()                                     { return state; }));
+    std::string job;
+    next.match<RUNNING>([&](const std::string& value) { job = value; });
+    int count = 0;
+    state.match<IDLE>([&](const int& value) { count = value; });
+    ONE_OF_CHECK(job == "job" && count == 2);
+
+    // The fallback handles the combinations without a case
+    ONE_OF_CHECK(one_of::match2(running, stop,
+        one_of::on<IDLE, START>([](const int&, const std::string&)  { return 0; }),
+        one_of::otherwise([]()                                      { return -1; })) == -1);
+
+    // Three OneOfs, the last one varying fastest in the table
+    const Priority high(HIGH{}, 3);
+    ONE_OF_CHECK(one_of::match3(running, ping, high,
+        one_of::on<RUNNING, PING, HIGH>([](const std::string& s, const int&, const int& p) { return static_cast<int>(s.size()) + p; }),
+        one_of::on<RUNNING, PING, LOW>([](const std::string&, const int&, const int&)       { return 0; }),
+        one_of::otherwise([]()                                                               { return -1; })) == 6);
+    return 0;
+}
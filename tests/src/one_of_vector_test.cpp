@@ -0,0 +1,82 @@
+#include "check.h"
+
+#include <one_of/one_of_vector.h>
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct Throwing
+{
+    explicit Throwing(bool fail) { if (fail) { throw std::runtime_error("Throwing"); } }
+};
+
+ONE_OF_CREATE_ALTERNATIVE(NUMBER,   int)
+ONE_OF_CREATE_ALTERNATIVE(TEXT,     std::string)
+ONE_OF_CREATE_ALTERNATIVE(THROWING, Throwing)
+
+typedef one_of::OneOfVector<NUMBER, TEXT, THROWING> Events;
+typedef Events::value_type Event;
+
+// Describes the elements in insertion order
+std::string describe(const Events& events)
+{
+    std::string result;
+    for (Events::const_reference event : events)
+    {
+        event.match<NUMBER>([&](const int& n) { result += std::to_string(n); })
+             .match<TEXT>([&](const std::string& t) { result += t; })
+             .match<THROWING>([&](const Throwing&) { result += "?"; });
+        result += ",";
+    }
+    return result;
+}
+
+int main()
+{
+    Events events;
+    ONE_OF_CHECK(events.empty() && events.begin() == events.end());
+
+    // The elements are stored one array per tag, and iterated in insertion order
+    events.emplace<NUMBER>(1);
+    const Event text(TEXT{}, std::string("two"));
+    events.push_back(text);
+    events.push_back(Event(NUMBER{}, 3));
+    Event moved(TEXT{}, std::string("four"));
+    events.push_back(std::move(moved));
+
+    ONE_OF_CHECK(events.size() == 4);
+    ONE_OF_CHECK(events.count<NUMBER>() == 2 && events.count<TEXT>() == 2 && events.count<THROWING>() == 0);
+    ONE_OF_CHECK(events.elements<TEXT>()[1] == "four");
+    ONE_OF_CHECK(describe(events) == "1,two,3,four,");
+
+    // emplace returns the constructed payload, and for_each only visits its tag
+    events.emplace<NUMBER>(5) *= 10;
+    events.for_each<NUMBER>([](int& n) { n += 1; });
+    int sum = 0;
+    static_cast<const Events&>(events).for_each<NUMBER>([&](const int& n) { sum += n; });
+    ONE_OF_CHECK(sum == 2 + 4 + 51);
+
+    // Elements are mutable through the references of a non-const iteration
+    for (Events::reference event : events) { event.match<TEXT>([](std::string& t) { t += "!"; }); }
+    ONE_OF_CHECK(describe(events) == "2,two!,4,four!,51,");
+
+    std::vector<uint32_t> indices;
+    for (Events::reference event : events) { indices.push_back(event.index()); }
+    ONE_OF_CHECK((indices == std::vector<uint32_t>{ 0, 1, 0, 1, 0 }));
+
+    // A throwing constructor leaves the tags and the arrays unchanged
+    bool thrown = false;
+    try { events.emplace<THROWING>(true); } catch (const std::runtime_error&) { thrown = true; }
+    ONE_OF_CHECK(thrown);
+    ONE_OF_CHECK(events.size() == 5 && events.count<THROWING>() == 0);
+    events.emplace<THROWING>(false);
+    ONE_OF_CHECK(describe(events) == "2,two!,4,four!,51,?,");
+
+    events.clear();
+    ONE_OF_CHECK(events.empty() && events.count<NUMBER>() == 0 && events.count<TEXT>() == 0);
+    ONE_OF_CHECK(describe(events).empty());
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "check.h"
+
+#include <one_of/shared_one_of.h>
+
+#include <string>
+#include <type_traits>
+#include <utility>
+
+ONE_OF_CREATE_ALTERNATIVE(TEXT,   std::string)
+ONE_OF_CREATE_ALTERNATIVE(NUMBER, int)
+typedef one_of::SharedOneOf<TEXT, NUMBER> Shared;
+
+static_assert(!std::is_convertible<TEXT, Shared>::value, "The construction from a tag is explicit");
+static_assert(!std::is_convertible<one_of::OneOf<TEXT, NUMBER>, Shared>::value, "The construction from a OneOf is explicit");
+
+static const void* payload(const Shared& shared)
+{
+    return one_of::details::OneOfAccess::payload(shared.get());
+}
+
+static std::string text(const Shared& shared)
+{
+    std::string result;
+    shared.match<TEXT>([&](const std::string& t) { result = t; });
+    return result;
+}
+
+int main()
+{
+    const Shared original(TEXT{}, std::string(64, 'x'));
+    Shared copy(original);
+    ONE_OF_CHECK(original.use_count() == 2 && payload(copy) == payload(original));
+
+    // Matching and visiting a non-const copy reads the shared payload
+    size_t size = 0;
+    copy.match<TEXT>([&](const std::string& t) { size = t.size(); });
+    ONE_OF_CHECK(size == 64);
+    ONE_OF_CHECK(copy.visit([](const std::string& t) { return t.size(); }, [](int) { return size_t(0); }) == 64);
+    ONE_OF_CHECK(original.use_count() == 2 && payload(copy) == payload(original));
+
+    // Mutating a shared copy clones its payload first
+    copy.mutate().match<TEXT>([](std::string& t) { t.assign("changed"); });
+    ONE_OF_CHECK(original.use_count() == 1 && copy.use_count() == 1);
+    ONE_OF_CHECK(text(original) == std::string(64, 'x') && text(copy) == "changed");
+
+    // But not the payload of a copy owning it alone
+    const void* owned = payload(copy);
+    copy.mutate().emplace<NUMBER>(3);
+    ONE_OF_CHECK(payload(copy) == owned && copy.index() == 1);
+
+    // The payload is moved out of its only owner, and copied out of a shared one
+    Shared other(original);
+    const one_of::OneOf<TEXT, NUMBER> copied = std::move(other).toOneOf();
+    ONE_OF_CHECK(original.use_count() == 1 && text(original) == std::string(64, 'x'));
+
+    Shared unique(TEXT{}, std::string("unique"));
+    const one_of::OneOf<TEXT, NUMBER> moved = std::move(unique).toOneOf();
+    std::string result;
+    moved.match<TEXT>([&](const std::string& t) { result = t; });
+    ONE_OF_CHECK(result == "unique" && copied.index() == 0);
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include "check.h"
+
+#include <one_of/one_of.h>
+
+#include <string.h>
+#include <string>
+#include <type_traits>
+
+enum class Color { RED, GREEN };
+struct Point { int x; int y; };
+
+ONE_OF_CREATE_ALTERNATIVE(INTEGER,  int)
+ONE_OF_CREATE_ALTERNATIVE(REAL,     double)
+ONE_OF_CREATE_ALTERNATIVE(COLOR,    Color)
+ONE_OF_CREATE_ALTERNATIVE(POINT,    Point)
+ONE_OF_CREATE_ALTERNATIVE(TEXT,     std::string)
+
+typedef one_of::OneOf<INTEGER, REAL, COLOR, POINT> Trivial;
+typedef one_of::OneOf<INTEGER, TEXT> NotTrivial;
+
+static_assert(std::is_trivially_copyable<Trivial>::value, "A OneOf of trivially copyable alternatives must be trivially copyable");
+static_assert(std::is_trivially_destructible<Trivial>::value, "A OneOf of trivially destructible alternatives must be trivially destructible");
+static_assert(std::is_trivially_copyable<Trivial::Variant>::value, "The union of trivially copyable alternatives must be trivially copyable");
+static_assert(std::is_trivially_destructible<Trivial::Variant>::value, "The union of trivially destructible alternatives must be trivially destructible");
+
+static_assert(!std::is_trivially_copyable<NotTrivial>::value, "");
+static_assert(!std::is_trivially_destructible<NotTrivial>::value, "");
+static_assert(!std::is_trivially_destructible<NotTrivial::Variant>::value, "");
+
+int main()
+{
+    // Trivially copyable OneOfs can be copied with memcpy
+    Trivial source(POINT(), Point{3, 4});
+    Trivial copy(INTEGER(), 0);
+    memcpy(static_cast<void*>(&copy), &source, sizeof(Trivial));
+
+    int x = 0;
+    copy.match<POINT>([&](const Point& point) { x = point.x; });
+    ONE_OF_CHECK(copy.index() == 3 && x == 3);
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include "check.h"
+
+#include <one_of/wire.h>
+
+#include <stdexcept>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Whether the type has wire traits, and can thus be encoded
+template<typename T, typename = void> struct encodable : std::false_type {};
+template<typename T> struct encodable<T, typename one_of::details::voider<typename one_of::wire_traits<T>::view_type>::type> : std::true_type {};
+
+struct Point { int x; int y; };
+static_assert(encodable<Point>::value && encodable<long long>::value, "Trivially copyable types are encoded");
+static_assert(!encodable<int*>::value && !encodable<const char*>::value && !encodable<int Point::*>::value, "Pointers are not encoded");
+
+// A payload claiming a size that does not fit in the header, which is never written
+struct Huge {};
+namespace one_of
+{
+    template<> struct wire_traits<Huge>
+    {
+        typedef const Huge& view_type;
+
+        static size_t size(const Huge&)                     { return static_cast<size_t>(UINT32_MAX) + 1; }
+        static void write(const Huge&, char*)               {}
+        static view_type view(const char*, size_t)          { static const Huge huge = {}; return huge; }
+        static Huge read(const char*, size_t)               { return Huge(); }
+        static bool valid_size(size_t)                      { return true; }
+    };
+}
+
+ONE_OF_CREATE_ALTERNATIVE(NUMBER,    long long)
+ONE_OF_CREATE_ALTERNATIVE(TEXT,      std::string)
+typedef one_of::OneOf<NUMBER, TEXT> Value;
+ONE_OF_CREATE_ALTERNATIVE(OVERSIZED, Huge)
+typedef one_of::OneOfView<NUMBER, TEXT> View;
+
+// An encoded OneOf whose header is written by hand, with an 8 bytes zeroed payload
+static std::vector<char> malformed(uint32_t payload_size, uint8_t index)
+{
+    std::vector<char> buffer(16, 0);
+    memcpy(buffer.data(), &payload_size, sizeof(payload_size));
+    buffer[4] = static_cast<char>(index);
+    return buffer;
+}
+
+int main()
+{
+    // Well formed buffers round trip
+    std::vector<char> buffer;
+    one_of::encode(Value(NUMBER{}, 42), buffer);
+    one_of::encode(Value(TEXT{}, "hello"), buffer);
+
+    View number(buffer.data());
+    ONE_OF_CHECK(number.isValid(buffer.size()));
+    long long decoded = 0;
+    number.decode().match<NUMBER>([&](const long long& value) { decoded = value; });
+    ONE_OF_CHECK(decoded == 42);
+
+    View text = number.next();
+    ONE_OF_CHECK(text.isValid(buffer.size() - number.encodedSize()));
+    std::string decoded_text;
+    text.decode().match<TEXT>([&](const std::string& value) { decoded_text = value; });
+    ONE_OF_CHECK(decoded_text == "hello");
+
+    // The payloads are matched and visited in place
+    one_of::StringView viewed = { nullptr, 0 };
+    bool number_matched = false;
+    text.match<NUMBER>([&](const long long&) { number_matched = true; })
+        .match<TEXT>([&](one_of::StringView value) { viewed = value; })
+        .assertMatchIsExhaustive();
+    ONE_OF_CHECK(!number_matched && viewed.str() == "hello");
+    ONE_OF_CHECK(viewed.data == buffer.data() + number.encodedSize() + one_of::wire_header_size);
+
+    ONE_OF_CHECK(number.visit([](const long long& value) { return value; }, [](one_of::StringView value) { return static_cast<long long>(value.size); }) == 42);
+    ONE_OF_CHECK(text.visit([](const long long& value) { return value; }, [](one_of::StringView value) { return static_cast<long long>(value.size); }) == 5);
+
+    // Payloads whose size does not fit in the header are not encoded
+    if (sizeof(size_t) > sizeof(uint32_t))
+    {
+        bool thrown = false;
+        std::vector<char> huge;
+        try { one_of::encode(one_of::OneOf<NUMBER, OVERSIZED>(OVERSIZED{}), huge); }
+        catch (const std::length_error&) { thrown = true; }
+        ONE_OF_CHECK(thrown && huge.empty());
+    }
+
+    // A long long payload must be exactly 8 bytes long, whatever the header claims
+    ONE_OF_CHECK(!View(malformed(0, 0).data()).isValid(16));
+    ONE_OF_CHECK(!View(malformed(4, 0).data()).isValid(16));
+    ONE_OF_CHECK(View(malformed(8, 0).data()).isValid(16));
+
+    // Strings may have any size, as long as they fit in the buffer
+    ONE_OF_CHECK(View(malformed(0, 1).data()).isValid(16));
+    ONE_OF_CHECK(!View(malformed(9, 1).data()).isValid(16));
+
+    // Unknown tags and truncated headers
+    ONE_OF_CHECK(!View(malformed(8, 2).data()).isValid(16));
+    ONE_OF_CHECK(!View(malformed(8, 0).data()).isValid(4));
+    return 0;
+}
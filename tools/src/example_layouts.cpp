@@ -0,0 +1,9 @@
+#include <one_of/layout.h>
+
+#include "types.h"
+
+// The OneOf types of the example, whose layouts one_of_layout prints
+
+ONE_OF_REPORT_LAYOUT(Request)
+ONE_OF_REPORT_LAYOUT(Response)
+ONE_OF_REPORT_LAYOUT(RateLimit)
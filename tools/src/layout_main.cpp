@@ -0,0 +1,13 @@
+#include <one_of/layout.h>
+
+#include <iostream>
+
+// Prints the layouts registered with ONE_OF_REPORT_LAYOUT by the other sources of the executable
+int main()
+{
+    for (const one_of::LayoutReport& report : one_of::layout_reports())
+    {
+        std::cout << report;
+    }
+    return 0;
+}